@@ -0,0 +1,180 @@
+//
+//  benchmark.cpp
+//  n_ranges_linear
+//
+//  Times boundary generation with small ranges, where the cost of finding each boundary dominates,
+//  and the fused range_stats() kernel against separate minmax_element() and accumulate() passes.
+//  Build with optimizations, and -mavx2 where available, for example:
+//      c++ -std=c++14 -O2 -mavx2 -I.. -I../example/lib benchmark.cpp -o benchmark
+//
+
+#define DOCTEST_CONFIG_IMPLEMENT
+#include <chrono>
+#include <vector>
+#include <string>
+#include <numeric>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include "n_ranges_linear.h"
+#include "n_ranges_boundaries.h"
+#include "range_stats.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+// private details
+namespace {
+
+    // The original per range multiply and modulo loop, kept as a baseline.
+    template<typename RandomIter, typename IterRangeFunc>
+    void for_n_ranges_linear_modulo(RandomIter begin, RandomIter end, const size_t ranges_size,
+        const size_t distribution_offset, IterRangeFunc range_func) {
+
+        const size_t input_size = distance(begin, end);
+        const size_t inputs_per_output = input_size / ranges_size;
+        const auto remainder_ratio = ec::positive_ratio(input_size % ranges_size, ranges_size);
+        for(size_t i = 0; i < ranges_size; ++i) {
+            auto b = begin;
+            begin += inputs_per_output + (((i + distribution_offset) *
+                remainder_ratio.first % remainder_ratio.second) < remainder_ratio.first ? 1 : 0);
+            range_func(i, b, begin);
+        }
+    }
+
+    template<typename Func>
+    double nanoseconds_per_range(const size_t ranges_size, Func func) {
+        const size_t repeats = max<size_t>(1, 20000000 / ranges_size);
+        const auto start = chrono::steady_clock::now();
+        for(size_t r = 0; r < repeats; ++r) {
+            func();
+        }
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        return elapsed.count() / double(repeats * ranges_size);
+    }
+
+    volatile size_t sink = 0;
+
+    // Columns of 1000 elements, as when drawing a long recording, per element.
+    template<typename T>
+    void stats_benchmark(const char* name) {
+        const size_t input_size = 1 << 20, ranges_size = input_size / 1000;
+        vector<T> data(input_size);
+        for(size_t k = 0; k < input_size; ++k) {
+            data[k] = T((k * 2654435761u) >> 20);
+        }
+
+        double checksum = 0.0;
+        const double separate = nanoseconds_per_range(input_size, [&]() {
+            ec::for_n_ranges_linear(data.begin(), data.end(), ranges_size, 0, [&](size_t, auto b, auto e) {
+                const auto minmax = minmax_element(b, e);
+                checksum += *minmax.first + *minmax.second + accumulate(b, e, 0.0);
+            });
+        });
+        const double fused = nanoseconds_per_range(input_size, [&]() {
+            ec::for_n_ranges_linear(data.begin(), data.end(), ranges_size, 0, [&](size_t, auto b, auto e) {
+                const auto stats = ec::range_stats(b, e);
+                checksum += stats.min + stats.max + double(stats.sum);
+            });
+        });
+        sink = size_t(checksum);
+
+        cout << setw(10) << name << setw(12) << input_size << fixed << setprecision(3)
+             << setw(16) << separate << setw(16) << fused << endl;
+    }
+
+    // Medians of columns of 1000 elements, copying and partitioning each range vs counting it into histograms, per element.
+    template<typename T>
+    void median_benchmark(const char* name) {
+        const size_t input_size = 1 << 20, ranges_size = input_size / 1000;
+        vector<T> data(input_size);
+        for(size_t k = 0; k < input_size; ++k) {
+            data[k] = T((k * 2654435761u) >> 13);
+        }
+
+        double checksum = 0.0;
+        const double partitioned = nanoseconds_per_range(input_size, [&]() {
+            ec::for_n_ranges_linear(data.begin(), data.end(), ranges_size, 0, [&](size_t, auto b, auto e) {
+                vector<T> copy(b, e);
+                const auto middle = copy.begin() + copy.size() / 2;
+                nth_element(copy.begin(), middle, copy.end());
+                double median = *middle;
+                if(copy.size() % 2 == 0) {
+                    median = (median + *max_element(copy.begin(), middle)) / 2.0;
+                }
+                checksum += median;
+            });
+        });
+        const double histogram = nanoseconds_per_range(input_size, [&]() {
+            ec::for_n_ranges_linear(data.begin(), data.end(), ranges_size, 0, [&](size_t, auto b, auto e) {
+                checksum += ec::range_median_histogram(b, e);
+            });
+        });
+        sink = size_t(checksum);
+
+        cout << setw(10) << name << setw(12) << input_size << fixed << setprecision(3)
+             << setw(16) << partitioned << setw(16) << histogram << endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main() {
+
+    cout << setw(10) << "ranges" << setw(12) << "inputs" << setw(16) << "modulo ns" << setw(16) << "stepper ns" << setw(16) << "boundaries ns" << endl;
+
+    for(size_t ranges_size : {1000, 3840, 100000, 1000000}) {
+        // 44.1kHz audio at high zoom: between one and four samples per range.
+        const size_t input_size = ranges_size * 2 + ranges_size * 37 / 41;
+        const vector<unsigned char> data(input_size);
+
+        size_t checksum = 0;
+        auto range_func = [&](size_t i, auto b, auto e) { checksum += i ^ size_t(e - b); };
+
+        const double modulo = nanoseconds_per_range(ranges_size, [&]() {
+            for_n_ranges_linear_modulo(data.begin(), data.end(), ranges_size, 0, range_func);
+        });
+        const double stepper = nanoseconds_per_range(ranges_size, [&]() {
+            ec::for_n_ranges_linear(data.begin(), data.end(), ranges_size, 0, range_func);
+        });
+        vector<uint32_t> boundaries(ranges_size + 1);
+        const double simd = nanoseconds_per_range(ranges_size, [&]() {
+            ec::n_ranges_linear_boundaries(input_size, ranges_size, 0, boundaries.data(), boundaries.size());
+            checksum += boundaries[ranges_size / 2];
+        });
+        sink = checksum;
+
+        cout << setw(10) << ranges_size << setw(12) << input_size << fixed << setprecision(3)
+             << setw(16) << modulo << setw(16) << stepper << setw(16) << simd << endl;
+    }
+
+    cout << endl << setw(10) << "type" << setw(12) << "inputs" << setw(16) << "separate ns" << setw(16) << "fused ns" << endl;
+    stats_benchmark<short>("short");
+    stats_benchmark<float>("float");
+
+    cout << endl << setw(10) << "type" << setw(12) << "inputs" << setw(16) << "nth_element ns" << setw(16) << "histogram ns" << endl;
+    median_benchmark<unsigned char>("uchar");
+    median_benchmark<short>("short");
+    return 0;
+}
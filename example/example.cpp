@@ -15,11 +15,11 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
-#include <thread>
-#include <future>
+#include <execution>
 
-#include "wave_peak.h"
 #include "n_ranges_linear.h"
+#include "n_ranges_parallel.h"
+#include "range_stats.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -58,25 +58,6 @@ namespace {
         T min, max, avg, med;
         double slope;
     };
-    
-    template<class RandomIter>
-    double median(RandomIter begin, RandomIter end) {
-        assert(begin < end);
-        const size_t size = distance(begin, end);
-        const size_t middle = size/2;
-        auto target = begin + middle;
-        nth_element(begin, target, end);
-
-        if(size % 2 != 0) { // Odd number of elements
-            return *target;
-        }
-        else { // Even number of elements
-            const double a = *target;
-            auto targetNeighbor = target-1;
-            nth_element(begin, targetNeighbor, end);
-            return (a + *targetNeighbor)/2.0;
-        }
-    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -123,11 +104,9 @@ int program_main(int argc, char** argv) {
     RIFF::file_data header;
     istream& ist = open_RIFF_file("example.wav", header);
     
-    typedef future<peak<unsigned char>> peak_future;
-    
-    vector<peak_future> peak_futures;
+    vector<peak<unsigned char>> peaks;
     vector<unsigned char> data;
-    peak_futures.reserve(width);
+    peaks.reserve(width);
     data.reserve(header.size);
     
     copy(istream_iterator<unsigned char>(ist), istream_iterator<unsigned char>(), back_inserter(data));
@@ -139,39 +118,28 @@ int program_main(int argc, char** argv) {
 // wave peak algorithm:
     cout << "Compressing " << header.size << " samples into " << width << " peaks at ~" << (header.size/width) << " samples per peak." << endl;
 
-    ec::transform_n_ranges_linear(data.begin(), data.end(), back_inserter(peak_futures), width, 0,
-    [](auto begin, auto end) -> peak_future {
-        return async(launch::async, [=]() -> peak<unsigned char> {
-        // min/max
-            const auto minmax = minmax_element(begin, end);
-        
-        // slope
-            double slope = 1.0;
-            if(minmax.first != minmax.second) {
-                const auto first = minmax.first < minmax.second ? minmax.first : minmax.second;
-                const auto second = minmax.first < minmax.second ? minmax.second : minmax.first;
-                slope = double(*second - *first)/double(distance(first, second));
-            }
-            
-        // mean average
-            const auto avg = accumulate(begin, end, 0)/distance(begin, end);
-        
-        // median
-            vector<unsigned char> mutable_copy;
-            mutable_copy.reserve(distance(begin, end));
-            copy(begin, end, back_inserter(mutable_copy));
-            const auto med = median(mutable_copy.begin(), mutable_copy.end());
+    // ranges are analyzed on the shared work stealing pool, results land in range order.
+    ec::transform_n_ranges_linear(execution::par, data.begin(), data.end(), back_inserter(peaks), width, 0,
+    [](auto begin, auto end) -> peak<unsigned char> {
+    // min/max, their positions, and the sum in a single pass
+        const auto stats = ec::range_stats(begin, end);
+    
+    // slope, between the first min and the first max
+        double slope = 1.0;
+        if(stats.min_index != stats.max_index) {
+            const auto first = begin + min(stats.min_index, stats.max_index);
+            const auto second = begin + max(stats.min_index, stats.max_index);
+            slope = double(*second - *first)/double(distance(first, second));
+        }
         
-        // done:
-            return peak<unsigned char>(*minmax.second, *minmax.first, avg, static_cast<unsigned char>(med), slope);
-        });
-    });
+    // mean average
+        const auto avg = stats.sum/stats.count;
     
-    vector<peak<unsigned char>> peaks;
-    peaks.reserve(peak_futures.size());
+    // median
+        const auto med = ec::range_median_histogram(begin, end);
     
-    transform(peak_futures.begin(), peak_futures.end(), back_inserter(peaks), [](auto& f) -> peak<unsigned char> {
-        return f.get();
+    // done:
+        return peak<unsigned char>(stats.max, stats.min, avg, static_cast<unsigned char>(med), slope);
     });
     
 // draw image:
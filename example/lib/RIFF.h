@@ -58,7 +58,7 @@ enum class format {
 /** Simple RIFF file data structure.
 */
 struct file_data {
-    format format;
+    enum format format;
     
     int32_t size;
     int32_t sample_rate;
@@ -133,7 +133,7 @@ inline file_data seek_RIFF_data(std::istream& ist) {
             data.format = static_cast<enum format>(int16_t(format));
             if(format_size == 18) {
                 rawbits<int16_t> extra_data;
-                RIFF_CHECKED_INPUT((ist >> extra_data) and ist.seekg(extra_data, ios_base::seekdir::cur));
+                RIFF_CHECKED_INPUT((ist >> extra_data) and ist.seekg(extra_data, ios_base::cur));
             }
         }
         else if(chunk_id == "RIFF") {
@@ -146,7 +146,7 @@ inline file_data seek_RIFF_data(std::istream& ist) {
         }
         else {
             rawbits<int32_t> skip_size;
-            RIFF_CHECKED_INPUT((ist >> skip_size) and ist.seekg(skip_size, ios_base::seekdir::cur));
+            RIFF_CHECKED_INPUT((ist >> skip_size) and ist.seekg(skip_size, ios_base::cur));
         }
         
         if(not found_data_chunk) {
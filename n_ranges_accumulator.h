@@ -0,0 +1,323 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_accumulator_h
+#define n_ranges_accumulator_h
+
+#include "n_ranges_linear.h"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Partitions a stream of elements that arrives in chunks, emitting each range as soon as it is complete.
+
+    The stream is divided as if it were a sequence of 'target_size' elements passed to for_n_ranges_linear(), but only the elements of the range currently being filled are retained. Ranges that lie entirely within a pushed chunk are passed to 'range_func' with the chunk's own iterators, and ranges that straddle chunks are gathered into an internal buffer of at most one range.
+
+        n_ranges_linear_accumulator<short> peaks(expected_samples, width, 0);
+        while(capture.read(block)) {
+            peaks.push(block.begin(), block.end(), draw_column);
+        }
+
+    The declared length can be changed at any time with retarget(). Ranges that have already been emitted are final, and the elements from the start of the current range to the new target are divided linearly among the ranges that remain, continuing the distribution pattern from the current range index. Retargeting is constant time and never revisits elements. If the target never changes the ranges are identical to those of for_n_ranges_linear(). A stream that stops short of any length it can be retargeted to is closed with finish().
+*/
+template<typename T>
+class n_ranges_linear_accumulator {
+public:
+    /** @param target_size The declared number of elements in the stream.
+        @param ranges_size The number of ranges to divide the stream into.
+        @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    */
+    n_ranges_linear_accumulator(const size_t target_size, const size_t ranges_size, const size_t distribution_offset)
+    : ranges_size_(ranges_size)
+    , distribution_offset_(distribution_offset)
+    , segment_first_element_(0)
+    , desc_(target_size, ranges_size, distribution_offset)
+    , step_(desc_)
+    , range_index_(0)
+    , range_begin_(0)
+    , range_end_(step_.next_size())
+    , consumed_(0) {
+    }
+
+    /** Consumes [begin, end), calling 'range_func(range_index, range_begin, range_end)' for every range completed.
+
+        PRECONDITIONS:
+            consumed() + distance(begin, end) <= target_size()
+    */
+    template<typename ForwardIter, typename IterRangeFunc>
+    void push(ForwardIter begin, ForwardIter end, IterRangeFunc range_func) {
+        while(begin != end) {
+            assert_true(not finished()); // More elements than declared.
+
+            const size_t needed = range_end_ - consumed_;
+            if(pending_.empty()) {
+                auto range_last = begin;
+                const size_t available = advance_up_to(range_last, end, needed);
+                if(available == needed) {
+                    consumed_ += needed;
+                    range_func(range_index(), begin, range_last);
+                    next_range();
+                }
+                else {
+                    pending_.insert(pending_.end(), begin, range_last);
+                    consumed_ += available;
+                }
+                begin = range_last;
+            }
+            else {
+                for(; begin != end and consumed_ < range_end_; ++begin, ++consumed_) {
+                    pending_.push_back(*begin);
+                }
+                if(consumed_ == range_end_) {
+                    range_func(range_index(), pending_.cbegin(), pending_.cend());
+                    pending_.clear();
+                    next_range();
+                }
+            }
+        }
+    }
+
+    /** Changes the declared length of the stream.
+
+        PRECONDITIONS:
+            not finished()
+            the ranges that have not been emitted still compress at least one element each
+            the current range does not shrink below the elements already pending
+    */
+    void retarget(const size_t target_size) {
+        assert_true(not finished());
+        assert_true(target_size > range_begin_);
+
+        // Built aside so that a target that would cut the current range short leaves the accumulator unchanged.
+        const n_ranges_linear_desc desc(target_size - range_begin_, ranges_size_ - range_index_,
+            distribution_offset_ + range_index_);
+        n_ranges_linear_stepper step(desc);
+        const size_t range_end = range_begin_ + step.next_size();
+        assert_true(range_end > consumed_);
+
+        segment_first_element_ = range_begin_;
+        desc_ = desc;
+        step_ = step;
+        range_end_ = range_end;
+    }
+
+    /** Ends the stream at consumed(), emitting every range not yet emitted.
+
+        For a stream that ends before its declared length, such as a capture stopped early. The elements received for the current range are emitted as that range, however few, and the ranges after it are emitted empty (begin == end), so 'range_func' is still called once for every range and the ranges already emitted are unchanged. If the stream reached its declared length, or finish() was already called, nothing is emitted.
+    */
+    template<typename IterRangeFunc>
+    void finish(IterRangeFunc range_func) {
+        if(finished()) {
+            return;
+        }
+        range_func(range_index(), pending_.cbegin(), pending_.cend());
+        pending_.clear();
+        for(++range_index_; range_index_ < ranges_size_; ++range_index_) {
+            range_func(range_index(), pending_.cend(), pending_.cend());
+        }
+        range_begin_ = range_end_ = consumed_;
+    }
+
+    /// The declared length of the stream.
+    size_t target_size() const {
+        return segment_first_element_ + desc_.input_size;
+    }
+
+    /// The number of elements pushed so far.
+    size_t consumed() const {
+        return consumed_;
+    }
+
+    /// The number of ranges passed to range_func so far, which is also the index of the range being filled.
+    size_t range_index() const {
+        return range_index_;
+    }
+
+    /// True once every range has been emitted.
+    bool finished() const {
+        return range_index_ == ranges_size_;
+    }
+
+private:
+    template<typename ForwardIter>
+    static size_t advance_up_to(ForwardIter& iter, ForwardIter end, const size_t n) {
+        typedef typename std::iterator_traits<ForwardIter>::iterator_category category;
+        return advance_up_to(iter, end, n, category());
+    }
+
+    template<typename RandomIter>
+    static size_t advance_up_to(RandomIter& iter, RandomIter end, const size_t n, std::random_access_iterator_tag) {
+        const size_t available = std::min<size_t>(n, std::distance(iter, end));
+        iter += available;
+        return available;
+    }
+
+    template<typename ForwardIter>
+    static size_t advance_up_to(ForwardIter& iter, ForwardIter end, const size_t n, std::forward_iterator_tag) {
+        size_t available = 0;
+        for(; available < n and iter != end; ++iter, ++available) {}
+        return available;
+    }
+
+    void next_range() {
+        ++range_index_;
+        range_begin_ = range_end_;
+        if(range_index_ < ranges_size_) {
+            range_end_ += step_.next_size();
+        }
+    }
+
+    size_t                  ranges_size_;
+    size_t                  distribution_offset_;
+    size_t                  segment_first_element_;
+    n_ranges_linear_desc    desc_;
+    n_ranges_linear_stepper step_;
+    size_t                  range_index_;
+    size_t                  range_begin_;
+    size_t                  range_end_;
+    size_t                  consumed_;
+    std::vector<T>          pending_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[n_ranges_linear_accumulator] VALID push(...)") {
+
+    vector<int> intin(10007);
+    iota(intin.begin(), intin.end(), 0);
+
+    auto sum = [](auto b, auto e) -> long { return accumulate(b, e, 0L); };
+    vector<long> expected;
+    transform_n_ranges_linear(intin.begin(), intin.end(), back_inserter(expected), 997, 3, sum);
+
+    SUBCASE("[n_ranges_linear_accumulator] chunks of any size match for_n_ranges_linear()") {
+        for(size_t chunk_size : {1, 3, 10, 11, 64, 1000, 10007}) {
+            n_ranges_linear_accumulator<int> acc(intin.size(), 997, 3);
+            vector<long> actual;
+            for(size_t b = 0; b < intin.size(); b += chunk_size) {
+                const size_t e = min(intin.size(), b + chunk_size);
+                acc.push(intin.begin() + b, intin.begin() + e, [&](size_t i, auto rb, auto re) {
+                    REQUIRE(i == actual.size());
+                    actual.push_back(sum(rb, re));
+                });
+            }
+            CHECK(acc.finished());
+            CHECK(actual == expected);
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_accumulator] retarget() divides the remainder linearly") {
+        n_ranges_linear_accumulator<int> acc(5000, 100, 0);
+        vector<size_t> sizes;
+        auto record = [&](size_t i, auto rb, auto re) {
+            REQUIRE(i == sizes.size());
+            sizes.push_back(distance(rb, re));
+        };
+        acc.push(intin.begin(), intin.begin() + 2525, record);
+        CHECK(sizes.size() == 50);
+        acc.retarget(intin.size());
+        CHECK(acc.target_size() == intin.size());
+        acc.push(intin.begin() + 2525, intin.end(), record);
+
+        CHECK(acc.finished());
+        REQUIRE(sizes.size() == 100);
+        CHECK(accumulate(sizes.begin(), sizes.end(), size_t(0)) == intin.size());
+        const auto tail = minmax_element(sizes.begin() + 50, sizes.end());
+        CHECK(*tail.second - *tail.first <= 1);
+    }
+
+    SUBCASE("[n_ranges_linear_accumulator] finish() closes a stream that ends early") {
+        n_ranges_linear_accumulator<int> acc(5000, 100, 0);
+        vector<long> sums;
+        vector<size_t> sizes;
+        auto record = [&](size_t i, auto rb, auto re) {
+            REQUIRE(i == sizes.size());
+            sizes.push_back(distance(rb, re));
+            sums.push_back(sum(rb, re));
+        };
+        // Range 50 spans [2500, 2550), and the stream stops inside it, below the declared length and the range end.
+        acc.push(intin.begin(), intin.begin() + 2500, record);
+        acc.push(intin.begin() + 2500, intin.begin() + 2510, record);
+        acc.push(intin.begin() + 2510, intin.begin() + 2525, record);
+        REQUIRE(sizes.size() == 50);
+        acc.finish(record);
+
+        CHECK(acc.finished());
+        REQUIRE(sizes.size() == 100);
+        CHECK(sizes[49] == 50);
+        CHECK(sizes[50] == 25);
+        CHECK(sums[50] == sum(intin.begin() + 2500, intin.begin() + 2525));
+        CHECK(all_of(sizes.begin() + 51, sizes.end(), [](size_t n) { return n == 0; }));
+        CHECK(accumulate(sizes.begin(), sizes.end(), size_t(0)) == 2525);
+
+        acc.finish(record);
+        CHECK(sizes.size() == 100);
+    }
+
+    SUBCASE("[n_ranges_linear_accumulator] INVALID retarget() below the pending elements") {
+        n_ranges_linear_accumulator<int> acc(1000, 10, 0);
+        acc.push(intin.begin(), intin.begin() + 150, [](size_t, auto, auto) {});
+        REQUIRE_THROWS(acc.retarget(400));
+        CHECK(acc.target_size() == 1000);
+        vector<size_t> sizes;
+        acc.push(intin.begin() + 150, intin.begin() + 1000, [&](size_t, auto rb, auto re) { sizes.push_back(distance(rb, re)); });
+        CHECK(acc.finished());
+        CHECK(sizes == vector<size_t>(9, 100));
+    }
+
+    SUBCASE("[n_ranges_linear_accumulator] INVALID push past the target") {
+        n_ranges_linear_accumulator<int> acc(100, 10, 0);
+        REQUIRE_THROWS(acc.push(intin.begin(), intin.begin() + 101, [](size_t, auto, auto) {}));
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_accumulator_h
@@ -0,0 +1,280 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_boundaries_h
+#define n_ranges_boundaries_h
+
+#include "n_ranges_linear.h"
+
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+/*  Each SIMD lane runs its own copy of n_ranges_linear_stepper, 'lanes' ranges apart.
+
+    Writing '(i + distribution_offset) * a' as 'k * d + error', the begin of range 'i' is:
+
+        i * inputs_per_output + k - extra_elements(distribution_offset) + (error >= a ? 1 : 0)
+
+    Moving a lane 'lanes' ranges forward adds 'lanes * a = K * d + R' to the product, so 'k' grows by 'K' plus a carry when 'error + R' wraps at 'd'. Everything except the lane setup is additions and comparisons. Lane values are signed, which limits the kernels to inputs that fit in half the lane width.
+*/
+template<typename SimdOps>
+size_t boundaries_simd(n_ranges_linear_desc const& desc, typename SimdOps::value_type* out, const size_t out_size) {
+    typedef typename SimdOps::lane_type lane_type;
+    typedef typename SimdOps::vector_type vector_type;
+    const size_t lanes = SimdOps::lanes;
+
+    if(out_size < lanes or desc.input_size > size_t(std::numeric_limits<lane_type>::max() / 2)) {
+        return 0;
+    }
+
+    const size_t q = desc.inputs_per_output;
+    const size_t a = desc.remainder_ratio.first;
+    const size_t d = desc.remainder_ratio.second;
+    const size_t o = desc.distribution_offset;
+    const size_t extra_before_offset = detail::multiply_add_divide(o, a, d - a, d).first;
+
+    lane_type base[lanes], error[lanes];
+    for(size_t l = 0; l < lanes; ++l) {
+        const auto product = detail::multiply_add_divide(l + o, a, 0, d);
+        base[l] = lane_type(l * q + product.first + 1 - extra_before_offset);
+        error[l] = lane_type(product.second);
+    }
+
+    vector_type vbase = SimdOps::load(base);
+    vector_type verror = SimdOps::load(error);
+    const vector_type vincrement = SimdOps::set1(lane_type(lanes * q + lanes * a / d + 1));
+    const vector_type vremainder = SimdOps::set1(lane_type(lanes * a % d));
+    const vector_type vdenominator = SimdOps::set1(lane_type(d));
+    const vector_type vnumerator = SimdOps::set1(lane_type(a));
+
+    size_t i = 0;
+    for(; i + lanes <= out_size; i += lanes) {
+        // cmpgt() is -1 when the lane has no extra element (error < a), which undoes the +1 held in base.
+        SimdOps::store(out + i, SimdOps::add(vbase, SimdOps::cmpgt(vnumerator, verror)));
+        const vector_type stepped = SimdOps::add(verror, vremainder);
+        const vector_type no_carry = SimdOps::cmpgt(vdenominator, stepped);
+        vbase = SimdOps::add(SimdOps::add(vbase, vincrement), no_carry);
+        verror = SimdOps::sub(stepped, SimdOps::andnot(no_carry, vdenominator));
+    }
+    return i;
+}
+
+#if defined(__AVX2__)
+struct avx2_u32_ops {
+    typedef uint32_t value_type;
+    typedef int32_t lane_type;
+    typedef __m256i vector_type;
+    static const size_t lanes = 8;
+    static vector_type load(lane_type const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+    static void store(value_type* p, vector_type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static vector_type set1(lane_type n) { return _mm256_set1_epi32(n); }
+    static vector_type add(vector_type x, vector_type y) { return _mm256_add_epi32(x, y); }
+    static vector_type sub(vector_type x, vector_type y) { return _mm256_sub_epi32(x, y); }
+    static vector_type cmpgt(vector_type x, vector_type y) { return _mm256_cmpgt_epi32(x, y); }
+    static vector_type andnot(vector_type x, vector_type y) { return _mm256_andnot_si256(x, y); }
+};
+
+struct avx2_u64_ops {
+    typedef uint64_t value_type;
+    typedef int64_t lane_type;
+    typedef __m256i vector_type;
+    static const size_t lanes = 4;
+    static vector_type load(lane_type const* p) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+    static void store(value_type* p, vector_type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static vector_type set1(lane_type n) { return _mm256_set1_epi64x(n); }
+    static vector_type add(vector_type x, vector_type y) { return _mm256_add_epi64(x, y); }
+    static vector_type sub(vector_type x, vector_type y) { return _mm256_sub_epi64(x, y); }
+    static vector_type cmpgt(vector_type x, vector_type y) { return _mm256_cmpgt_epi64(x, y); }
+    static vector_type andnot(vector_type x, vector_type y) { return _mm256_andnot_si256(x, y); }
+};
+#elif defined(__SSE2__)
+struct sse2_u32_ops {
+    typedef uint32_t value_type;
+    typedef int32_t lane_type;
+    typedef __m128i vector_type;
+    static const size_t lanes = 4;
+    static vector_type load(lane_type const* p) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p)); }
+    static void store(value_type* p, vector_type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static vector_type set1(lane_type n) { return _mm_set1_epi32(n); }
+    static vector_type add(vector_type x, vector_type y) { return _mm_add_epi32(x, y); }
+    static vector_type sub(vector_type x, vector_type y) { return _mm_sub_epi32(x, y); }
+    static vector_type cmpgt(vector_type x, vector_type y) { return _mm_cmpgt_epi32(x, y); }
+    static vector_type andnot(vector_type x, vector_type y) { return _mm_andnot_si128(x, y); }
+};
+#endif
+
+// Returns the number of leading boundaries written, the caller finishes the rest. Without a SIMD overload for T nothing is written.
+template<typename T>
+size_t boundaries_kernel(n_ranges_linear_desc const&, T*, size_t) {
+    return 0;
+}
+
+#if defined(__AVX2__)
+inline size_t boundaries_kernel(n_ranges_linear_desc const& desc, uint32_t* out, const size_t out_size) {
+    return boundaries_simd<avx2_u32_ops>(desc, out, out_size);
+}
+
+inline size_t boundaries_kernel(n_ranges_linear_desc const& desc, uint64_t* out, const size_t out_size) {
+    return boundaries_simd<avx2_u64_ops>(desc, out, out_size);
+}
+#elif defined(__SSE2__)
+inline size_t boundaries_kernel(n_ranges_linear_desc const& desc, uint32_t* out, const size_t out_size) {
+    return boundaries_simd<sse2_u32_ops>(desc, out, out_size);
+}
+#endif
+
+} // END namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Writes the first element index of consecutive ranges into a flat array.
+
+    'out[i]' is set to the begin of range 'i' for every i in [0, out_size), so passing 'ranges_size + 1' entries also writes the input end. The results are identical to the boundaries visited by for_n_ranges_linear(). For uint32_t output, 8 boundaries per instruction are generated with AVX2 or 4 with SSE2, and for uint64_t output 4 per instruction with AVX2, selected by the compiler target flags (eg. -mavx2). Other element types, and inputs too large for the SIMD lanes, use the scalar n_ranges_linear_stepper.
+
+    @param desc The partition to generate boundaries for.
+    @param out The array to fill, of at least 'out_size' elements.
+    @param out_size The number of boundaries to write.
+
+    PRECONDITIONS:
+        out_size <= desc.ranges_size + 1
+        every boundary is representable in T
+*/
+template<typename T>
+void n_ranges_linear_boundaries(n_ranges_linear_desc const& desc, T* out, const size_t out_size) {
+    assert_true(out_size <= desc.ranges_size + 1);
+    assert_true(out_size == 0 or desc.range_begin(out_size - 1) <= size_t(std::numeric_limits<T>::max()));
+
+    const size_t first = detail::boundaries_kernel(desc, out, out_size);
+
+    n_ranges_linear_stepper step(desc, first);
+    for(size_t i = first; i < out_size; ++i) {
+        out[i] = T(step.range_begin);
+        step.next_size();
+    }
+}
+
+
+/** Writes the first element index of consecutive ranges into a flat array.
+
+    @see n_ranges_linear_boundaries(desc, out, out_size) and for_n_ranges_linear() for the other parameters.
+*/
+template<typename T>
+void n_ranges_linear_boundaries(const size_t input_size, const size_t ranges_size, const size_t distribution_offset,
+    T* out, const size_t out_size) {
+    n_ranges_linear_boundaries(n_ranges_linear_desc(input_size, ranges_size, distribution_offset), out, out_size);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+template<typename T>
+void check_boundaries(const size_t input_size, const size_t ranges_size, const size_t offset) {
+    vector<T> expected;
+    vector<char> in(input_size);
+    for_n_ranges_linear(in.begin(), in.end(), ranges_size, offset, [&](size_t, auto b, auto) {
+        expected.push_back(T(b - in.begin()));
+    });
+    expected.push_back(T(input_size));
+
+    vector<T> actual(ranges_size + 1);
+    n_ranges_linear_boundaries(input_size, ranges_size, offset, actual.data(), actual.size());
+    REQUIRE(actual == expected);
+
+    vector<T> partial(ranges_size / 2);
+    n_ranges_linear_boundaries(input_size, ranges_size, offset, partial.data(), partial.size());
+    REQUIRE(equal(partial.begin(), partial.end(), expected.begin()));
+}
+
+TEST_CASE("[n_ranges_linear_boundaries] VALID n_ranges_linear_boundaries(...)") {
+
+    for(size_t input_size : {7, 27, 100, 4099, 44100, 1000003}) {
+        for(size_t ranges_size : {1, 2, 6, 9, 64, 1000, 4098, 77777}) {
+            if(ranges_size >= input_size) { continue; }
+            for(size_t offset : {0, 1, 13, 9999}) {
+                check_boundaries<uint32_t>(input_size, ranges_size, offset);
+                check_boundaries<uint64_t>(input_size, ranges_size, offset);
+                check_boundaries<int64_t>(input_size, ranges_size, offset);
+            }
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_boundaries] inputs beyond 2^40 elements") {
+        if(sizeof(size_t) == 8) {
+            const n_ranges_linear_desc desc((size_t(1) << 42) + 12345, (size_t(1) << 33) + 1, 77);
+            vector<uint64_t> out(1000);
+            n_ranges_linear_boundaries(desc, out.data(), out.size());
+            for(size_t i = 0; i < out.size(); ++i) {
+                REQUIRE(out[i] == desc.range_begin(i));
+            }
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_boundaries] INVALID output size") {
+        vector<uint32_t> out(12);
+        REQUIRE_THROWS(n_ranges_linear_boundaries(100, 10, 0, out.data(), out.size()));
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_boundaries_h
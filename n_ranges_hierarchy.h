@@ -0,0 +1,238 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_hierarchy_h
+#define n_ranges_hierarchy_h
+
+#include "n_ranges_linear.h"
+
+#include <vector>
+#include <utility>
+#include <iterator>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Describes the division of 'input_size' elements through several levels of fan out, such as socket, then core, then SIMD block.
+
+    Dividing each level separately with nested for_n_ranges_linear() calls rounds at every level, so the extra elements of each level pile up in the first children of every parent. Instead, the leaves of the hierarchy are the ranges of a single partition into 'product(fan_outs)' ranges, and each node above them is the contiguous run of its leaves. The remainder is then spread linearly across all leaves, and because any run of 'm' consecutive ranges holds within one element of 'm * input_size/leaves_size' elements, the nodes of every level are also equal +/-1.
+
+        const n_ranges_linear_hierarchy topology(tasks.size(), {sockets, cores_per_socket, 8}, 0);
+        const auto socket_range = topology.range({socket}); // [begin, end) of one socket's elements
+
+    A node is identified by its index path from the root, one index per level, with the last level varying fastest.
+*/
+struct n_ranges_linear_hierarchy {
+    /** @param input_size The number of elements to divide.
+        @param fan_outs The number of children of each node, per level from the root down.
+        @param distribution_offset When calculating the distribution of the leaves this offset is applied. @see for_n_ranges_linear() for more information.
+    */
+    n_ranges_linear_hierarchy(const size_t input_size, std::vector<size_t> fan_outs, const size_t distribution_offset)
+    : fan_outs(std::move(fan_outs))
+    , leaves(input_size, leaves_size_of(this->fan_outs), distribution_offset) {
+    }
+
+    /// The index of the leaf at the start of the node at 'path', where 'path' has at most one index per level.
+    size_t first_leaf(std::vector<size_t> const& path) const {
+        assert_true(path.size() <= fan_outs.size());
+        size_t leaf = 0;
+        for(size_t level = 0; level < fan_outs.size(); ++level) {
+            const size_t index = level < path.size() ? path[level] : 0;
+            assert_true(index < fan_outs[level]);
+            leaf = leaf * fan_outs[level] + index;
+        }
+        return leaf;
+    }
+
+    /// The number of leaves under a node at 'depth' levels below the root.
+    size_t leaves_under(const size_t depth) const {
+        assert_true(depth <= fan_outs.size());
+        size_t span = 1;
+        for(size_t level = depth; level < fan_outs.size(); ++level) {
+            span *= fan_outs[level];
+        }
+        return span;
+    }
+
+    /// The [begin, end) element indexes of the node at 'path', an empty path is the whole input.
+    std::pair<size_t, size_t> range(std::vector<size_t> const& path) const {
+        const size_t first = first_leaf(path);
+        return std::make_pair(leaves.range_begin(first), leaves.range_begin(first + leaves_under(path.size())));
+    }
+
+    /// The index path of leaf 'leaf_index', one index per level.
+    std::vector<size_t> path_of_leaf(size_t leaf_index) const {
+        assert_true(leaf_index < leaves.ranges_size);
+        std::vector<size_t> path(fan_outs.size());
+        for(size_t level = fan_outs.size(); level > 0; --level) {
+            path[level - 1] = leaf_index % fan_outs[level - 1];
+            leaf_index /= fan_outs[level - 1];
+        }
+        return path;
+    }
+
+    std::vector<size_t>     fan_outs;
+    n_ranges_linear_desc    leaves;
+
+private:
+    static size_t leaves_size_of(std::vector<size_t> const& fan_outs) {
+        assert_true(not fan_outs.empty());
+        size_t leaves_size = 1;
+        for(size_t fan_out : fan_outs) {
+            assert_true(fan_out > 0);
+            leaves_size *= fan_out;
+        }
+        return leaves_size;
+    }
+};
+
+
+/** Visits the leaf ranges of a hierarchy in order, with the index path of each.
+
+    For example, pinning work to a socket, core, and SIMD block:
+
+        for_n_ranges_linear_hierarchy(samples.begin(), samples.end(), {sockets, cores_per_socket, 8}, 0,
+        [&](std::vector<size_t> const& path, auto begin, auto end) {
+            workers[path[0]][path[1]].schedule(path[2], begin, end);
+        });
+
+    @see n_ranges_linear_hierarchy for how the elements are divided.
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param fan_outs The number of children of each node, per level from the root down.
+    @param distribution_offset When calculating the distribution of the leaves this offset is applied. @see for_n_ranges_linear() for more information.
+    @param leaf_func The func that takes the index path (one index per level), begin, and end iterators.
+
+    PRECONDITIONS:
+        fan_outs is not empty and has no zeros
+        0 < product(fan_outs) < distance(begin, end)
+    POSTCONDITIONS:
+        every element has been ordered into a leaf and passed to leaf_func
+*/
+template<typename ForwardIter, typename LeafFunc>
+void for_n_ranges_linear_hierarchy (
+    ForwardIter                 begin,
+    ForwardIter                 end,
+    std::vector<size_t> const&  fan_outs,
+    const size_t                distribution_offset,
+    LeafFunc                    leaf_func
+) {
+    using namespace std;
+
+    assert_true(detail::is_ordered(begin, end, typename iterator_traits<ForwardIter>::iterator_category()));
+
+    const n_ranges_linear_hierarchy hierarchy(distance(begin, end), fan_outs, distribution_offset);
+    vector<size_t> path(fan_outs.size(), 0);
+    auto visit_leaf = [&](size_t, ForwardIter b, ForwardIter e) {
+        leaf_func(static_cast<vector<size_t> const&>(path), b, e);
+        size_t level = path.size();
+        while(level > 0 and ++path[level - 1] == fan_outs[level - 1]) {
+            path[--level] = 0;
+        }
+    };
+    begin = detail::visit_ranges(begin, hierarchy.leaves, visit_leaf);
+
+    assert_true(begin == end);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[n_ranges_linear_hierarchy] VALID for_n_ranges_linear_hierarchy(...)") {
+
+    SUBCASE("[n_ranges_linear_hierarchy] leaves are one global partition") {
+        vector<int> in(1009);
+        vector<pair<size_t, size_t>> flat;
+        for_n_ranges_linear(in.begin(), in.end(), 24, 5, [&](size_t, auto b, auto e) {
+            flat.emplace_back(b - in.begin(), e - in.begin());
+        });
+
+        const n_ranges_linear_hierarchy hierarchy(in.size(), {2, 3, 4}, 5);
+        size_t leaf = 0;
+        for_n_ranges_linear_hierarchy(in.begin(), in.end(), {2, 3, 4}, 5, [&](vector<size_t> const& path, auto b, auto e) {
+            REQUIRE(path == hierarchy.path_of_leaf(leaf));
+            REQUIRE(hierarchy.first_leaf(path) == leaf);
+            REQUIRE(flat[leaf] == make_pair(size_t(b - in.begin()), size_t(e - in.begin())));
+            REQUIRE(hierarchy.range(path) == flat[leaf]);
+            ++leaf;
+        });
+        CHECK(leaf == 24);
+        CHECK(hierarchy.range({}) == make_pair(size_t(0), in.size()));
+        CHECK(hierarchy.range({1}) == make_pair(flat[12].first, in.size()));
+        CHECK(hierarchy.range({0, 2}) == make_pair(flat[8].first, flat[11].second));
+    }
+
+    SUBCASE("[n_ranges_linear_hierarchy] every level is equal +/-1") {
+        const vector<size_t> fan_outs = {3, 5, 7};
+        for(size_t input_size : {106, 1000, 4099, 44100}) {
+            for(size_t offset : {0, 1, 17}) {
+                const n_ranges_linear_hierarchy hierarchy(input_size, fan_outs, offset);
+                vector<size_t> sockets, cores;
+                for(size_t s = 0; s < 3; ++s) {
+                    const auto socket = hierarchy.range({s});
+                    sockets.push_back(socket.second - socket.first);
+                    for(size_t c = 0; c < 5; ++c) {
+                        const auto core = hierarchy.range({s, c});
+                        cores.push_back(core.second - core.first);
+                    }
+                }
+                const auto socket_sizes = minmax_element(sockets.begin(), sockets.end());
+                const auto core_sizes = minmax_element(cores.begin(), cores.end());
+                CHECK(*socket_sizes.second - *socket_sizes.first <= 1);
+                CHECK(*core_sizes.second - *core_sizes.first <= 1);
+            }
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_hierarchy] INVALID more leaves than elements") {
+        REQUIRE_THROWS(n_ranges_linear_hierarchy(100, {10, 10}, 0));
+        REQUIRE_THROWS(n_ranges_linear_hierarchy(100, {}, 0));
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_hierarchy_h
@@ -23,8 +23,12 @@
 #ifndef n_ranges_linear_h
 #define n_ranges_linear_h
 
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
 #include <utility>
 #include <iterator>
 #include <type_traits>
@@ -32,9 +36,11 @@
 #ifndef DOCTEST_CONFIG_DISABLE
 #include <doctest.h>
 
-#include <vector>
+#include <list>
 #include <string>
 #include <numeric>
+#include <algorithm>
+#include <forward_list>
 #include <sstream>
 #include <iostream>
 #include <exception>
@@ -58,13 +64,13 @@ namespace ec {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template<typename T>
-T greatest_common_divisor(T n, T d) {
+constexpr T greatest_common_divisor(T n, T d) {
     return d == 0 ? n : greatest_common_divisor<T>(d, n % d);
 }
 
 
 template<typename T>
-std::pair<T, T> positive_ratio(T num, T den) {
+constexpr std::pair<T, T> positive_ratio(T num, T den) {
     static_assert(std::is_unsigned<T>::value, "positive_ratio() only works on unsigned types.");
     
     const T gcd = greatest_common_divisor(num, den);
@@ -74,9 +80,262 @@ std::pair<T, T> positive_ratio(T num, T den) {
 };
 
 
+namespace detail {
+
+/** Returns the quotient and remainder of '(a * b + c) / d' without overflowing the intermediate product.
+
+    Partition arithmetic multiplies indexes by the remainder ratio, or element indexes by the number of ranges, and those products overflow size_t long before the inputs do (eg. 2^40 elements in 2^25 ranges). When 'a', 'b', and 'c' all fit in half a size_t the plain product is exact and is used, so results for small inputs are unchanged. Otherwise the product is formed at double width, with unsigned __int128 where the compiler has it, or with 32 bit partial products and bitwise long division where it does not.
+
+    PRECONDITIONS:
+        d > 0
+        the quotient fits in a size_t
+*/
+inline std::pair<size_t, size_t> multiply_add_divide(const size_t a, const size_t b, const size_t c, const size_t d) {
+    const int half = std::numeric_limits<size_t>::digits / 2;
+    if(((a | b | c) >> half) == 0) {
+        const size_t n = a * b + c;
+        return std::make_pair(n / d, n % d);
+    }
+#if defined(__SIZEOF_INT128__)
+    typedef std::conditional_t<sizeof(size_t) <= sizeof(std::uint32_t), std::uint64_t, unsigned __int128> wide_t;
+    const wide_t n = wide_t(a) * b + c;
+    return std::make_pair(size_t(n / d), size_t(n % d));
+#else
+    const size_t mask = (size_t(1) << half) - 1;
+    const size_t lo_lo = (a & mask) * (b & mask);
+    const size_t hi_lo = (a >> half) * (b & mask);
+    const size_t lo_hi = (a & mask) * (b >> half);
+    const size_t middle = (lo_lo >> half) + (hi_lo & mask) + lo_hi;
+    size_t high = (a >> half) * (b >> half) + (hi_lo >> half) + (middle >> half);
+    size_t low = (middle << half) | (lo_lo & mask);
+    low += c;
+    high += low < c ? 1 : 0;
+
+    size_t quotient = 0, remainder = 0;
+    for(int bit = 4 * half - 1; bit >= 0; --bit) {
+        const bool carry = (remainder >> (2 * half - 1)) != 0;
+        const size_t next = bit >= 2 * half ? (high >> (bit - 2 * half)) & 1 : (low >> bit) & 1;
+        remainder = (remainder << 1) | next;
+        quotient <<= 1;
+        if(carry or remainder >= d) {
+            remainder -= d;
+            quotient |= 1;
+        }
+    }
+    return std::make_pair(quotient, remainder);
+#endif
+}
+
+} // END namespace detail
+
+
+/** Describes the division of 'input_size' elements into 'ranges_size' 'equalest-possible' ranges.
+
+    Holds everything for_n_ranges_linear() derives before it walks the input, so that the bounds of any single range can be calculated in constant time without visiting the ranges before it. A worker that owns range 'i' can seek directly to its own elements:
+    
+        const n_ranges_linear_desc desc(distance(tasks.begin(), tasks.end()), workers.size(), 0);
+        const auto r = desc.range(worker_index);
+        for_each(tasks.begin() + r.first, tasks.begin() + r.second, schedule);
+ 
+    With 'a/d' as the reduced remainder ratio, range 'j' gets an extra element when '(j + distribution_offset) * a % d < a', which is exactly when 'floor(x * a/d)' steps up from 'x - 1' to 'x' (where 'x = j + distribution_offset'). The number of extra elements before range 'i' therefore telescopes to 'floor((i + offset) * a/d) - floor(offset * a/d)' (shifted by one place so that no negative terms occur), and the first element of range 'i' is:
+ 
+        i * inputs_per_output + extra_elements(i + offset) - extra_elements(offset)
+ 
+    The distribution pattern repeats every 'd' ranges, so 'distribution_offset' is stored modulo 'd'.
+ 
+    @see for_n_ranges_linear() for a discussion of the distribution and its preconditions.
+*/
+struct n_ranges_linear_desc {
+    n_ranges_linear_desc(const size_t input_size, const size_t ranges_size, const size_t distribution_offset)
+    : input_size(input_size)
+    , ranges_size(ranges_size)
+    , inputs_per_output(ranges_size > 0 ? input_size / ranges_size : 0)
+    , remainder_ratio(ranges_size > 0 ? positive_ratio(input_size % ranges_size, ranges_size) : std::make_pair(size_t(0), size_t(1)))
+    , distribution_offset(distribution_offset % remainder_ratio.second) {
+        assert_true(ranges_size > 0);
+        assert_true(ranges_size < input_size); // We can only compress, not expand.
+        assert_true(inputs_per_output > 0);
+        assert_true(remainder_ratio.first < remainder_ratio.second);
+    }
+    
+    /// The index of the first element in range 'range_index', range_begin(ranges_size) == input_size.
+    size_t range_begin(const size_t range_index) const {
+        assert_true(range_index <= ranges_size);
+        return range_index * inputs_per_output
+            + extra_elements(range_index + distribution_offset) - extra_elements(distribution_offset);
+    }
+    
+    /// The index one past the last element in range 'range_index'.
+    size_t range_end(const size_t range_index) const {
+        return range_begin(range_index + 1);
+    }
+    
+    /// The number of elements in range 'range_index', either inputs_per_output or inputs_per_output + 1.
+    size_t range_size(const size_t range_index) const {
+        return inputs_per_output + (detail::multiply_add_divide(range_index + distribution_offset,
+            remainder_ratio.first, 0, remainder_ratio.second).second < remainder_ratio.first ? 1 : 0);
+    }
+    
+    /// The [begin, end) element indexes of range 'range_index'.
+    std::pair<size_t, size_t> range(const size_t range_index) const {
+        return std::make_pair(range_begin(range_index), range_end(range_index));
+    }
+    
+    /** The index of the range containing element 'element_index', consistent with range_begin() and range_end().
+ 
+        Every range begin lies within one element of its exact fractional position 'i * input_size/ranges_size', and every range has at least one element, so the scaled guess 'element_index * ranges_size/input_size' is either the owning range or the one before it.
+    */
+    size_t range_of_element(const size_t element_index) const {
+        assert_true(element_index < input_size);
+        const size_t guess = detail::multiply_add_divide(element_index, ranges_size, 0, input_size).first;
+        return guess + (range_begin(guess + 1) <= element_index ? 1 : 0);
+    }
+    
+    /** Writes the owning range index of every element index in [first, last) to 'output_iter'.
+ 
+        Sorted indexes are mapped in a single forward walk over the ranges, stepping once per range crossed with no division. An index lower than the one before it, or far beyond the current range, falls back to range_of_element() and the walk resumes from there, so the indexes may be in any order.
+     
+        @return The output iterator one past the last written range index.
+    */
+    template<typename InputIter, typename OutputIter>
+    OutputIter range_of_elements(InputIter first, InputIter last, OutputIter output_iter) const;
+    
+    size_t                      input_size;
+    size_t                      ranges_size;
+    size_t                      inputs_per_output;
+    std::pair<size_t, size_t>   remainder_ratio;
+    size_t                      distribution_offset;
+    
+private:
+    // Number of ranges in [0, x) with an extra element, plus one when there is any remainder at all.
+    size_t extra_elements(const size_t x) const {
+        return detail::multiply_add_divide(x, remainder_ratio.first, remainder_ratio.second - remainder_ratio.first, remainder_ratio.second).first;
+    }
+};
+
+
+/** Generates consecutive range sizes of a partition using only additions and comparisons.
+
+    Range 'i' gets an extra element when '(i + distribution_offset) * a % d < a', with 'a/d' as the reduced remainder ratio. Rather than multiplying and taking the modulo for every range, the stepper keeps that product modulo 'd' as a running error term, adding 'a' and wrapping at 'd' as it moves from one range to the next, like Bresenham's line algorithm. The sizes and boundaries are identical to those of n_ranges_linear_desc.
+ 
+        n_ranges_linear_stepper step(desc);
+        while(step.range_index < desc.ranges_size) {
+            const size_t b = step.range_begin;
+            visit(b, b + step.next_size());
+        }
+*/
+struct n_ranges_linear_stepper {
+    explicit n_ranges_linear_stepper(n_ranges_linear_desc const& desc, const size_t first_range = 0)
+    : range_index(first_range)
+    , range_begin(desc.range_begin(first_range))
+    , inputs_per_output(desc.inputs_per_output)
+    , numerator(desc.remainder_ratio.first)
+    , denominator(desc.remainder_ratio.second)
+    , error(detail::multiply_add_divide((first_range + desc.distribution_offset) % denominator, numerator, 0, denominator).second) {
+    }
+    
+    /// The size of range 'range_index', after which range_index and range_begin move to the next range.
+    size_t next_size() {
+        const size_t size = inputs_per_output + (error < numerator ? 1 : 0);
+        error += numerator;
+        error -= error >= denominator ? denominator : 0;
+        range_begin += size;
+        ++range_index;
+        return size;
+    }
+    
+    size_t range_index;
+    size_t range_begin;
+    
+private:
+    size_t inputs_per_output;
+    size_t numerator;
+    size_t denominator;
+    size_t error;
+};
+
+
+template<typename InputIter, typename OutputIter>
+OutputIter n_ranges_linear_desc::range_of_elements(InputIter first, InputIter last, OutputIter output_iter) const {
+    if(first == last) {
+        return output_iter;
+    }
+
+    // Beyond this many elements past the current range a seek is cheaper than stepping.
+    const size_t seek_distance = 16 * (inputs_per_output + 1);
+
+    // After next_size() the stepper's range_begin is the end of range 'range_index - 1', the current range.
+    size_t element = *first;
+    n_ranges_linear_stepper step(*this, range_of_element(element));
+    step.next_size();
+    for(;;) {
+        assert_true(element < input_size);
+        *output_iter++ = step.range_index - 1;
+        if(++first == last) {
+            return output_iter;
+        }
+
+        const size_t previous = element;
+        element = *first;
+        if(element < previous or element >= step.range_begin + seek_distance) {
+            step = n_ranges_linear_stepper(*this, range_of_element(element));
+            step.next_size();
+        }
+        else {
+            while(element >= step.range_begin) {
+                step.next_size();
+            }
+        }
+    }
+}
+
+
+namespace detail {
+
+template<typename RandomIter>
+bool is_ordered(RandomIter begin, RandomIter end, std::random_access_iterator_tag) {
+    return begin <= end;
+}
+
+template<typename ForwardIter>
+bool is_ordered(ForwardIter, ForwardIter, std::forward_iterator_tag) {
+    return true; // Can't be checked without walking the sequence.
+}
+
+// Advances 'begin' over each range exactly once, returning the end of the last range.
+template<typename ForwardIter, typename IterRangeFunc>
+ForwardIter visit_ranges(ForwardIter begin, n_ranges_linear_desc const& desc, IterRangeFunc& range_func) {
+    n_ranges_linear_stepper step(desc);
+    for(size_t i = 0; i < desc.ranges_size; ++i) {
+        auto b = begin;
+        std::advance(begin, step.next_size());
+        range_func(i, b, begin);
+    }
+    return begin;
+}
+
+// Visits ranges [first_range, last_range) of 'desc' by seeking once and then stepping.
+template<typename ForwardIter, typename IterRangeFunc>
+void visit_range_window(ForwardIter begin, n_ranges_linear_desc const& desc, const size_t first_range, const size_t last_range,
+    IterRangeFunc& range_func) {
+    assert_true(first_range <= last_range and last_range <= desc.ranges_size);
+
+    n_ranges_linear_stepper step(desc, first_range);
+    auto b = std::next(begin, step.range_begin);
+    while(step.range_index < last_range) {
+        const size_t i = step.range_index;
+        auto e = std::next(b, step.next_size());
+        range_func(i, b, e);
+        b = e;
+    }
+}
+
+} // END namespace detail
+
+
 /** Visits a sequence of elements in chunks of 'n' 'equalest-possible' ranges.
 
-    Takes a discrete sequence of elements and splits them into roughly equal sized ranges, passing them one at a time to a function taking two random access iterators (begin, end). The resulting ranges are 'distance(begin, end)/ranges_size' in size, with 'distance(begin, end)%ranges_size' ranges having +1 element due to the integer division remainder being distributed linearly across the resulting ranges.
+    Takes a discrete sequence of elements and splits them into roughly equal sized ranges, passing them one at a time to a function taking two iterators (begin, end). Random access iterators seek to each boundary directly, while forward and bidirectional iterators (eg. from std::list) are advanced exactly once over the sequence after its length is measured, @see for_n_ranges_linear_n() to avoid measuring it. The resulting ranges are 'distance(begin, end)/ranges_size' in size, with 'distance(begin, end)%ranges_size' ranges having +1 element due to the integer division remainder being distributed linearly across the resulting ranges.
     
     For example, distributing an unknown number of tasks among workers:
         
@@ -114,38 +373,94 @@ std::pair<T, T> positive_ratio(T num, T den) {
     POSTCONDITIONS:
         every element has been ordered into a range and passed to range_func
 */
-template<typename RandomIter, typename IterRangeFunc>
+template<typename ForwardIter, typename IterRangeFunc>
 void for_n_ranges_linear (
-    RandomIter      begin,
-    RandomIter      end,
+    ForwardIter     begin,
+    ForwardIter     end,
     const size_t    ranges_size,
     const size_t    distribution_offset,
     IterRangeFunc   range_func
 ) {
     using namespace std;
 
-    assert_true(begin <= end);
+    assert_true(detail::is_ordered(begin, end, typename iterator_traits<ForwardIter>::iterator_category()));
     
-    const size_t input_size = distance(begin, end);
+    const n_ranges_linear_desc desc(distance(begin, end), ranges_size, distribution_offset);
+    begin = detail::visit_ranges(begin, desc, range_func);
 
-    assert_true(ranges_size > 0);
-    assert_true(ranges_size < input_size); // We can only compress, not expand.
+    assert_true(begin == end);
+}
 
-    const size_t inputs_per_output = input_size / ranges_size;
-    const size_t remainder = input_size % ranges_size;
-    
-    assert_true(inputs_per_output > 0);
-    assert_true(remainder < ranges_size);
-    
-    const auto remainder_ratio = positive_ratio(remainder, ranges_size);
-    for(size_t i = 0; i < ranges_size; ++i) {
-        auto b = begin;
-        begin += inputs_per_output + (((i + distribution_offset) *
-            remainder_ratio.first % remainder_ratio.second) < remainder_ratio.first ? 1 : 0);
-        range_func(i, b, begin);
-    }
 
-    assert_true(begin == end);
+/** Visits the 'input_size' elements starting at 'begin' in chunks of 'n' 'equalest-possible' ranges.
+
+    Like for_n_ranges_linear(), but with the length of the sequence given up front, so that forward iterators (eg. from std::forward_list, or a cursor over a segmented log) walk the sequence in a single pass.
+ 
+    @param begin The beginning of the input range.
+    @param input_size The number of elements in the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+    @return The iterator one past the last element.
+ 
+    PRECONDITIONS:
+        [begin, begin + input_size) is a valid range
+        @see: for_n_ranges_linear()
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename ForwardIter, typename IterRangeFunc>
+ForwardIter for_n_ranges_linear_n (
+    ForwardIter     begin,
+    const size_t    input_size,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    IterRangeFunc   range_func
+) {
+    const n_ranges_linear_desc desc(input_size, ranges_size, distribution_offset);
+    return detail::visit_ranges(begin, desc, range_func);
+}
+
+
+/** Visits only ranges [first_range, last_range) of a sequence divided into 'n' 'equalest-possible' ranges.
+
+    The ranges, and the range indexes passed to 'range_func', are identical to those for_n_ranges_linear() would visit for the same window, but the walk starts at 'first_range' directly from the closed form boundary, so the cost is proportional to the window rather than to the whole partition. For example, drawing only the columns on screen of an hour long recording divided into millions of columns:
+
+        for_n_ranges_linear_window(samples.begin(), samples.end(), total_columns, 0,
+            scroll_column, scroll_column + screen_width, draw_column);
+
+    With forward iterators the elements before the window are still stepped over once (@see for_n_ranges_linear_n()), but no range before the window is computed.
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param first_range The index of the first range to visit.
+    @param last_range One past the index of the last range to visit.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+
+    PRECONDITIONS:
+        first_range <= last_range <= ranges_size
+        @see: for_n_ranges_linear()
+    POSTCONDITIONS:
+        every element of the window has been ordered into a range and passed to range_func
+*/
+template<typename ForwardIter, typename IterRangeFunc>
+void for_n_ranges_linear_window (
+    ForwardIter     begin,
+    ForwardIter     end,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    const size_t    first_range,
+    const size_t    last_range,
+    IterRangeFunc   range_func
+) {
+    using namespace std;
+
+    assert_true(detail::is_ordered(begin, end, typename iterator_traits<ForwardIter>::iterator_category()));
+
+    const n_ranges_linear_desc desc(distance(begin, end), ranges_size, distribution_offset);
+    detail::visit_range_window(begin, desc, first_range, last_range, range_func);
 }
 
 
@@ -164,20 +479,396 @@ void for_n_ranges_linear (
     POSTCONDITIONS:
         @see: for_n_ranges_linear()
 */
-template<typename RandomIter, typename OutputIter, typename IterRangeFunc>
+template<typename ForwardIter, typename OutputIter, typename IterRangeFunc>
 void transform_n_ranges_linear (
-    RandomIter      begin,
-    RandomIter      end,
+    ForwardIter     begin,
+    ForwardIter     end,
     OutputIter      output_iter,
     const size_t    ranges_size,
     const size_t    distribution_offset,
     IterRangeFunc   range_func
 ) {
-    for_n_ranges_linear(begin, end, ranges_size, distribution_offset, [&](size_t range_index, auto b, auto e) {
+    for_n_ranges_linear(begin, end, ranges_size, distribution_offset, [&](size_t, auto b, auto e) {
         *output_iter++ = range_func(b, e);
     });
 }
 
+
+/** Reduces a sequence of elements to one value by mapping each of 'n' 'equalest-possible' ranges and combining the results in range order.
+
+    Equivalent to transform_n_ranges_linear() followed by std::accumulate(), without storing the intermediate results:
+
+        const auto energy = reduce_n_ranges_linear(samples.begin(), samples.end(), width, 0, 0.0,
+            [](auto b, auto e) { return rms(b, e); },
+            [](double a, double b) { return a + b; });
+
+    For a parallel version @see n_ranges_parallel.h, which requires 'combine' to be associative. For more about the algorithm @see: for_n_ranges_linear()
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param identity The initial value, which 'combine' leaves unchanged.
+    @param map_range Takes (begin, end) and returns a value convertible to T.
+    @param combine Takes two T values and returns their combination.
+    @return 'combine(...combine(combine(identity, map_range(range 0)), map_range(range 1))..., map_range(range n - 1))'
+
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename ForwardIter, typename T, typename MapRangeFunc, typename CombineFunc>
+T reduce_n_ranges_linear (
+    ForwardIter     begin,
+    ForwardIter     end,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    T               identity,
+    MapRangeFunc    map_range,
+    CombineFunc     combine
+) {
+    for_n_ranges_linear(begin, end, ranges_size, distribution_offset, [&](size_t, auto b, auto e) {
+        identity = combine(std::move(identity), map_range(b, e));
+    });
+    return identity;
+}
+
+
+namespace detail {
+
+// Calls 'run_func(first_range, element, next_element, run_size)' for the run of ranges owned by each element.
+template<typename ForwardIter, typename RunFunc>
+void visit_runs(ForwardIter begin, ForwardIter end, const size_t ranges_size, const size_t distribution_offset, RunFunc run_func) {
+    using namespace std;
+    
+    assert_true(is_ordered(begin, end, typename iterator_traits<ForwardIter>::iterator_category()));
+    
+    const size_t input_size = distance(begin, end);
+    assert_true(input_size > 0);
+    assert_true(ranges_size >= input_size); // We can only expand, not compress.
+    
+    if(ranges_size == input_size) {
+        for(size_t i = 0; i < ranges_size; ++i, ++begin) {
+            run_func(i, begin, next(begin), size_t(1));
+        }
+        return;
+    }
+    
+    const n_ranges_linear_desc runs(ranges_size, input_size, distribution_offset);
+    n_ranges_linear_stepper step(runs);
+    for(; begin != end; ++begin) {
+        const size_t first_range = step.range_begin;
+        run_func(first_range, begin, next(begin), step.next_size());
+    }
+}
+
+} // END namespace detail
+
+
+/** Visits a sequence of elements that is smaller than the number of ranges wanted, expanding each element into a run of ranges.
+
+    The inverse of for_n_ranges_linear(): instead of elements being divided among ranges, ranges are divided among elements. Each element is given a run of 'ranges_size/distance(begin, end)' consecutive ranges, with the remainder distributed linearly (and shifted by 'distribution_offset') exactly as for_n_ranges_linear() distributes extra elements. Every range passed to 'range_func' holds the single element that owns it.
+ 
+    For example, zooming past one sample per pixel:
+ 
+        for_n_ranges_linear_expand(samples.begin(), samples.end(), width, 0,
+        [&](size_t column, auto begin, auto end) {
+            draw_column(column, *begin);
+        });
+ 
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to expand this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+ 
+    PRECONDITIONS:
+        begin < end
+        ranges_size >= distance(begin, end)
+    POSTCONDITIONS:
+        every range has been passed to range_func, in order
+*/
+template<typename ForwardIter, typename IterRangeFunc>
+void for_n_ranges_linear_expand (
+    ForwardIter     begin,
+    ForwardIter     end,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    IterRangeFunc   range_func
+) {
+    detail::visit_runs(begin, end, ranges_size, distribution_offset,
+    [&](size_t first_range, ForwardIter element, ForwardIter element_end, size_t run_size) {
+        for(size_t i = first_range; i < first_range + run_size; ++i) {
+            range_func(i, element, element_end);
+        }
+    });
+}
+
+
+/** Transforms a sequence of elements into more outputs than there are elements, for interpolation.
+
+    The ranges are distributed as in for_n_ranges_linear_expand(). For each range 'range_func' is given the element that owns it, the element after (or 'end' for the last element), and the position of the range in the element's run, so that values can be interpolated between neighbours:
+ 
+        transform_n_ranges_linear_expand(samples.begin(), samples.end(), back_inserter(columns), width, 0,
+        [&](auto sample, auto next, size_t step, size_t steps) -> double {
+            const double to = next == samples.end() ? *sample : *next;
+            return *sample + (to - *sample) * step / steps;
+        });
+ 
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param output_iter The write iterator for the results.
+    @param ranges_size The number of outputs to expand this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param range_func Transform func that takes (element, next_element, step, steps) and returns an arbitrary value insertable into output_iter.
+ 
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear_expand()
+*/
+template<typename ForwardIter, typename OutputIter, typename ElementStepFunc>
+void transform_n_ranges_linear_expand (
+    ForwardIter     begin,
+    ForwardIter     end,
+    OutputIter      output_iter,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    ElementStepFunc range_func
+) {
+    detail::visit_runs(begin, end, ranges_size, distribution_offset,
+    [&](size_t, ForwardIter element, ForwardIter next_element, size_t run_size) {
+        for(size_t step = 0; step < run_size; ++step) {
+            *output_iter++ = range_func(element, next_element, step, run_size);
+        }
+    });
+}
+
+
+/** Visits a sequence of elements in 'ranges_size' ranges at any scale.
+
+    Compresses with for_n_ranges_linear() when there are more elements than ranges, and expands with for_n_ranges_linear_expand() otherwise, so that a single call site serves every zoom level. Either way 'range_func' is called once per range, in order, with a non-empty range of elements.
+ 
+    @see for_n_ranges_linear() and for_n_ranges_linear_expand() for the parameters.
+*/
+template<typename ForwardIter, typename IterRangeFunc>
+void for_n_ranges_linear_scaled (
+    ForwardIter     begin,
+    ForwardIter     end,
+    const size_t    ranges_size,
+    const size_t    distribution_offset,
+    IterRangeFunc   range_func
+) {
+    if(ranges_size < size_t(std::distance(begin, end))) {
+        for_n_ranges_linear(begin, end, ranges_size, distribution_offset, range_func);
+    }
+    else {
+        for_n_ranges_linear_expand(begin, end, ranges_size, distribution_offset, range_func);
+    }
+}
+
+
+/** A reusable description of a partition, with optional precomputed tables.
+
+    Building a plan performs all of the ratio and boundary arithmetic once, so that a plan can be applied every frame to any input of 'input_size' elements without repeating it. The table chosen trades memory for work in the loop:
+ 
+        no_table            Only the n_ranges_linear_desc is kept, sizes are calculated per range.
+        size_pattern_table  One period of range sizes is stored. The distribution repeats every 'remainder_ratio.second' ranges, so range 'i' has size 'sizes[i % sizes.size()]'.
+        boundary_table      Every range begin is stored ('ranges_size + 1' entries), giving arithmetic free random access.
+ 
+    For example, while the user scrubs:
+ 
+        const n_ranges_plan plan(samples.size(), width, 0, n_ranges_plan::boundary_table);
+        transform_n_ranges_linear(samples.begin(), samples.end(), back_inserter(peaks), plan, analyze);
+*/
+struct n_ranges_plan {
+    enum table_kind { no_table, size_pattern_table, boundary_table };
+    
+    n_ranges_plan(const size_t input_size, const size_t ranges_size, const size_t distribution_offset, const table_kind table = size_pattern_table)
+    : desc(input_size, ranges_size, distribution_offset)
+    , table(table) {
+        n_ranges_linear_stepper step(desc);
+        if(table == size_pattern_table) {
+            sizes.resize(desc.remainder_ratio.second);
+            for(size_t i = 0; i < sizes.size(); ++i) {
+                sizes[i] = step.next_size();
+            }
+        }
+        else if(table == boundary_table) {
+            boundaries.resize(ranges_size + 1);
+            boundaries[0] = 0;
+            for(size_t i = 0; i < ranges_size; ++i) {
+                boundaries[i + 1] = boundaries[i] + step.next_size();
+            }
+        }
+    }
+    
+    /// The index of the first element in range 'range_index', @see n_ranges_linear_desc::range_begin().
+    size_t range_begin(const size_t range_index) const {
+        return table == boundary_table ? boundaries[range_index] : desc.range_begin(range_index);
+    }
+    
+    n_ranges_linear_desc    desc;
+    table_kind              table;
+    std::vector<size_t>     sizes;      // One period of range sizes, when table == size_pattern_table.
+    std::vector<size_t>     boundaries; // Every range begin and the input end, when table == boundary_table.
+};
+
+
+/** Visits a sequence of elements in the ranges described by a prebuilt plan.
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param plan The partition to apply, built for 'distance(begin, end)' elements.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+ 
+    PRECONDITIONS:
+        distance(begin, end) == plan.desc.input_size
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename RandomIter, typename IterRangeFunc>
+void for_n_ranges_linear (
+    RandomIter              begin,
+    RandomIter              end,
+    n_ranges_plan const&    plan,
+    IterRangeFunc           range_func
+) {
+    using namespace std;
+    
+    assert_true(distance(begin, end) >= 0 and size_t(distance(begin, end)) == plan.desc.input_size);
+    
+    const size_t ranges_size = plan.desc.ranges_size;
+    if(plan.table == n_ranges_plan::boundary_table) {
+        for(size_t i = 0; i < ranges_size; ++i) {
+            range_func(i, begin + plan.boundaries[i], begin + plan.boundaries[i + 1]);
+        }
+    }
+    else if(plan.table == n_ranges_plan::size_pattern_table) {
+        const size_t period = plan.sizes.size();
+        for(size_t i = 0, j = 0; i < ranges_size; ++i) {
+            auto b = begin;
+            begin += plan.sizes[j];
+            if(++j == period) {
+                j = 0;
+            }
+            range_func(i, b, begin);
+        }
+        assert_true(begin == end);
+    }
+    else {
+        n_ranges_linear_stepper step(plan.desc);
+        for(size_t i = 0; i < ranges_size; ++i) {
+            auto b = begin;
+            begin += step.next_size();
+            range_func(i, b, begin);
+        }
+        assert_true(begin == end);
+    }
+}
+
+
+/** Transforms a sequence of elements in the ranges described by a prebuilt plan.
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param output_iter The write iterator for the results.
+    @param plan The partition to apply, built for 'distance(begin, end)' elements.
+    @param range_func Transform func that takes (begin, end) and returns an arbitrary value insertable into output_iter.
+ 
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename RandomIter, typename OutputIter, typename IterRangeFunc>
+void transform_n_ranges_linear (
+    RandomIter              begin,
+    RandomIter              end,
+    OutputIter              output_iter,
+    n_ranges_plan const&    plan,
+    IterRangeFunc           range_func
+) {
+    for_n_ranges_linear(begin, end, plan, [&](size_t, auto b, auto e) {
+        *output_iter++ = range_func(b, e);
+    });
+}
+
+/** The partition of 'InputSize' elements into 'RangesSize' ranges, calculated at compile time.
+
+    For fixed size blocks (eg. 4096 sample audio buffers into 64 meter segments) the remainder ratio and every boundary are constant expressions, identical to those of n_ranges_linear_desc.
+ 
+    @see n_ranges_linear_boundary_table() and for_n_ranges_linear<InputSize, RangesSize, DistributionOffset>().
+*/
+template<size_t InputSize, size_t RangesSize, size_t DistributionOffset = 0>
+struct n_ranges_linear_constants {
+    static_assert(RangesSize > 0, "n_ranges_linear_constants needs at least one range.");
+    static_assert(RangesSize < InputSize, "n_ranges_linear_constants can only compress, not expand.");
+    
+    static constexpr size_t input_size = InputSize;
+    static constexpr size_t ranges_size = RangesSize;
+    static constexpr size_t inputs_per_output = InputSize / RangesSize;
+    static constexpr size_t numerator = positive_ratio(InputSize % RangesSize, RangesSize).first;
+    static constexpr size_t denominator = positive_ratio(InputSize % RangesSize, RangesSize).second;
+    static constexpr size_t distribution_offset = DistributionOffset % denominator;
+    
+    /// @see n_ranges_linear_desc::range_begin()
+    static constexpr size_t range_begin(const size_t range_index) {
+        return range_index * inputs_per_output
+            + extra_elements(range_index + distribution_offset) - extra_elements(distribution_offset);
+    }
+    
+private:
+    static constexpr size_t extra_elements(const size_t x) {
+        return (x * numerator + denominator - numerator) / denominator;
+    }
+};
+
+namespace detail {
+
+template<typename Constants, size_t... RangeIndexes>
+constexpr std::array<size_t, sizeof...(RangeIndexes)> boundary_table(std::index_sequence<RangeIndexes...>) {
+    return {{ Constants::range_begin(RangeIndexes)... }};
+}
+
+template<typename Constants, typename RandomIter, typename IterRangeFunc, size_t... RangeIndexes>
+void for_n_ranges_unrolled(RandomIter begin, IterRangeFunc& range_func, std::index_sequence<RangeIndexes...>) {
+    const int expand[] = { 0, (range_func(RangeIndexes,
+        begin + std::integral_constant<size_t, Constants::range_begin(RangeIndexes)>::value,
+        begin + std::integral_constant<size_t, Constants::range_begin(RangeIndexes + 1)>::value), 0)... };
+    (void)expand;
+}
+
+} // END namespace detail
+
+
+/** A compile time table of every range begin and the input end ('RangesSize + 1' entries).
+
+    For example, a static lookup table for metering:
+    
+        constexpr auto meter_bounds = n_ranges_linear_boundary_table<4096, 64>();
+        static_assert(meter_bounds[64] == 4096, "");
+*/
+template<size_t InputSize, size_t RangesSize, size_t DistributionOffset = 0>
+constexpr std::array<size_t, RangesSize + 1> n_ranges_linear_boundary_table() {
+    return detail::boundary_table<n_ranges_linear_constants<InputSize, RangesSize, DistributionOffset>>(
+        std::make_index_sequence<RangesSize + 1>());
+}
+
+
+/** Visits 'InputSize' elements from 'begin' in 'RangesSize' ranges known at compile time.
+
+    Every boundary is a constant expression and the loop is unrolled into one call of 'range_func' per range, so this is best suited to modest range counts.
+ 
+    @param begin The beginning of the input range, which must have at least 'InputSize' elements.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+ 
+    @see for_n_ranges_linear() for a discussion of the distribution.
+*/
+template<size_t InputSize, size_t RangesSize, size_t DistributionOffset = 0, typename RandomIter, typename IterRangeFunc>
+void for_n_ranges_linear(RandomIter begin, IterRangeFunc range_func) {
+    detail::for_n_ranges_unrolled<n_ranges_linear_constants<InputSize, RangesSize, DistributionOffset>>(
+        begin, range_func, std::make_index_sequence<RangesSize>());
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -237,6 +928,63 @@ TEST_CASE("[transform_n_ranges_linear] VALID transform_n_ranges_linear(...)") {
     }
 }
 
+TEST_CASE("[reduce_n_ranges_linear] VALID reduce_n_ranges_linear(...)") {
+
+    list<int> in(1001);
+    iota(in.begin(), in.end(), 0);
+    vector<long> sums;
+    transform_n_ranges_linear(in.begin(), in.end(), back_inserter(sums), 13, 2, [](auto b, auto e) { return accumulate(b, e, 0L); });
+
+    const auto largest = reduce_n_ranges_linear(in.begin(), in.end(), 13, 2, 0L,
+        [](auto b, auto e) { return accumulate(b, e, 0L); },
+        [](long x, long y) { return max(x, y); });
+    CHECK(largest == *max_element(sums.begin(), sums.end()));
+
+    const string order = reduce_n_ranges_linear(in.begin(), in.end(), 4, 0, string(">"),
+        [](auto b, auto) { return to_string(*b); },
+        [](string x, string const& y) { return x + " " + y; });
+    CHECK(order == "> 0 251 501 751");
+}
+
+TEST_CASE("[for_n_ranges_linear_window] VALID for_n_ranges_linear_window(...)") {
+
+    vector<int> in(100003);
+    vector<pair<size_t, size_t>> full;
+    for_n_ranges_linear(in.begin(), in.end(), 20000, 7, [&](size_t, auto b, auto e) {
+        full.emplace_back(b - in.begin(), e - in.begin());
+    });
+
+    SUBCASE("[for_n_ranges_linear_window] windows match the full partition") {
+        const pair<size_t, size_t> windows[] = {{0, 0}, {0, 1}, {0, 20000}, {123, 2123}, {19999, 20000}, {20000, 20000}};
+        for(auto window : windows) {
+            size_t next = window.first;
+            for_n_ranges_linear_window(in.begin(), in.end(), 20000, 7, window.first, window.second, [&](size_t i, auto b, auto e) {
+                REQUIRE(i == next++);
+                REQUIRE(full[i] == make_pair(size_t(b - in.begin()), size_t(e - in.begin())));
+            });
+            CHECK(next == window.second);
+        }
+    }
+
+    SUBCASE("[for_n_ranges_linear_window] forward iterators") {
+        forward_list<int> flist(in.begin(), in.begin() + 1000);
+        vector<size_t> sizes;
+        for_n_ranges_linear_window(flist.begin(), flist.end(), 300, 1, 100, 110, [&](size_t, auto b, auto e) {
+            sizes.push_back(distance(b, e));
+        });
+        const n_ranges_linear_desc desc(1000, 300, 1);
+        REQUIRE(sizes.size() == 10);
+        for(size_t i = 0; i < sizes.size(); ++i) {
+            CHECK(sizes[i] == desc.range_size(100 + i));
+        }
+    }
+
+    SUBCASE("[for_n_ranges_linear_window] INVALID window") {
+        REQUIRE_THROWS(for_n_ranges_linear_window(in.begin(), in.end(), 20000, 0, 10, 5, [](size_t, auto, auto) {}));
+        REQUIRE_THROWS(for_n_ranges_linear_window(in.begin(), in.end(), 20000, 0, 0, 20001, [](size_t, auto, auto) {}));
+    }
+}
+
 TEST_CASE("[transform_n_ranges_linear] INVALID transform_n_ranges_linear(...)") {
     
     vector<int> intin;
@@ -248,11 +996,298 @@ TEST_CASE("[transform_n_ranges_linear] INVALID transform_n_ranges_linear(...)")
         
         REQUIRE_THROWS(transform_n_ranges_linear(intin.begin(), intin.end(), back_inserter(strout),
             numeric_limits<size_t>::max(), /* <-- Too many regions requested. */
-            0, [](auto begin, auto end) -> string { return ""; }));
+            0, [](auto, auto) -> string { return ""; }));
         
         REQUIRE_THROWS(transform_n_ranges_linear(intin.begin(), intin.end(), back_inserter(strout),
             0, /* <-- Not enough regions requested. */
-            0, [](auto begin, auto end) -> string { return ""; }));
+            0, [](auto, auto) -> string { return ""; }));
+    }
+}
+
+TEST_CASE("[n_ranges_linear_desc] VALID n_ranges_linear_desc(...)") {
+    
+    SUBCASE("[n_ranges_linear_desc] range(i) matches for_n_ranges_linear()") {
+        const size_t inputs[] = {2, 7, 27, 100, 1000, 4096, 44100};
+        const size_t offsets[] = {0, 1, 5, 13, 9999};
+        for(size_t input_size : inputs) {
+            vector<int> in(input_size);
+            for(size_t ranges_size = 1; ranges_size < input_size and ranges_size < 300; ranges_size += 1 + ranges_size/8) {
+                for(size_t offset : offsets) {
+                    const n_ranges_linear_desc desc(input_size, ranges_size, offset);
+                    for_n_ranges_linear(in.begin(), in.end(), ranges_size, offset, [&](size_t i, auto b, auto e) {
+                        const auto r = desc.range(i);
+                        REQUIRE(r.first == size_t(distance(in.begin(), b)));
+                        REQUIRE(r.second == size_t(distance(in.begin(), e)));
+                        REQUIRE(desc.range_size(i) == size_t(distance(b, e)));
+                    });
+                    REQUIRE(desc.range_begin(0) == 0);
+                    REQUIRE(desc.range_begin(ranges_size) == input_size);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("[n_ranges_linear_desc] VALID range_of_element(...)") {
+    
+    SUBCASE("[n_ranges_linear_desc] range_of_element(k) inverts range(i)") {
+        const size_t inputs[] = {2, 7, 27, 100, 1000, 4099};
+        const size_t offsets[] = {0, 1, 5, 13, 9999};
+        for(size_t input_size : inputs) {
+            for(size_t ranges_size = 1; ranges_size < input_size and ranges_size < 300; ranges_size += 1 + ranges_size/8) {
+                for(size_t offset : offsets) {
+                    const n_ranges_linear_desc desc(input_size, ranges_size, offset);
+                    for(size_t i = 0; i < ranges_size; ++i) {
+                        const auto r = desc.range(i);
+                        for(size_t k = r.first; k < r.second; ++k) {
+                            REQUIRE(desc.range_of_element(k) == i);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    SUBCASE("[n_ranges_linear_desc] range_of_elements() maps a batch of indexes") {
+        const n_ranges_linear_desc desc(27, 6, 1);
+        const vector<size_t> elements = {0, 3, 4, 5, 13, 22, 26};
+        vector<size_t> ranges;
+        desc.range_of_elements(elements.begin(), elements.end(), back_inserter(ranges));
+        REQUIRE(ranges.size() == elements.size());
+        for(size_t i = 0; i < elements.size(); ++i) {
+            CHECK(ranges[i] == desc.range_of_element(elements[i]));
+        }
+        CHECK(ranges.front() == 0);
+        CHECK(ranges.back() == 5);
+    }
+
+    SUBCASE("[n_ranges_linear_desc] range_of_elements() walks sorted indexes and seeks unsorted ones") {
+        for(size_t input_size : {size_t(997), size_t(100003)}) {
+            const n_ranges_linear_desc desc(input_size, 331, 5);
+            vector<size_t> elements;
+            for(size_t k = 0; k < input_size; k += 1 + k % 7) {
+                elements.push_back(k);
+            }
+            elements.push_back(input_size - 1);
+            const size_t sorted_size = elements.size();
+            for(size_t k = 0; k < 200; ++k) {
+                elements.push_back(k * 7919 % input_size);
+            }
+            vector<size_t> ranges;
+            desc.range_of_elements(elements.begin(), elements.end(), back_inserter(ranges));
+            REQUIRE(ranges.size() == elements.size());
+            for(size_t i = 0; i < elements.size(); ++i) {
+                REQUIRE(ranges[i] == desc.range_of_element(elements[i]));
+            }
+            CHECK(ranges[sorted_size - 1] == 330);
+        }
+    }
+}
+
+TEST_CASE("[n_ranges_linear_desc] VALID inputs beyond 2^40 elements") {
+
+    SUBCASE("[n_ranges_linear_desc] multiply_add_divide() is exact") {
+        CHECK(detail::multiply_add_divide(1000, 27, 5, 7) == make_pair(size_t(3857), size_t(6)));
+        if(sizeof(size_t) == 8) {
+            const size_t max = numeric_limits<size_t>::max();
+            CHECK(detail::multiply_add_divide((size_t(1) << 40) + 3, (size_t(1) << 33) + 5, 7, (size_t(1) << 35) + 1)
+                == make_pair(size_t(274877907096), size_t(25769803646)));
+            CHECK(detail::multiply_add_divide(max, max, 0, max) == make_pair(max, size_t(0)));
+            CHECK(detail::multiply_add_divide((size_t(1) << 63) + 5, (size_t(1) << 62) + 11, 3, (size_t(1) << 63) + (size_t(1) << 62) + 1)
+                == make_pair(size_t(3074457345618258611), size_t(6148914691236517255)));
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_desc] boundaries, sizes, and lookups stay consistent") {
+        if(sizeof(size_t) < 8) {
+            return;
+        }
+        const size_t input_size = (size_t(1) << 42) + 12345;
+        for(size_t ranges_size : {size_t(1) << 25, (size_t(1) << 33) + 1, (size_t(1) << 41) - 3}) {
+            for(size_t offset : {size_t(0), size_t(1), ranges_size / 3}) {
+                const n_ranges_linear_desc desc(input_size, ranges_size, offset);
+                REQUIRE(desc.range_begin(0) == 0);
+                REQUIRE(desc.range_begin(ranges_size) == input_size);
+
+                n_ranges_linear_stepper step(desc, ranges_size - 1000);
+                for(size_t i : {size_t(0), size_t(1), size_t(12345), ranges_size / 2, ranges_size - 1000}) {
+                    n_ranges_linear_stepper seek(desc, i);
+                    REQUIRE(seek.range_begin == desc.range_begin(i));
+                    for(size_t j = i; j < i + 1000; ++j) {
+                        const auto r = desc.range(j);
+                        REQUIRE(r.second - r.first == desc.range_size(j));
+                        REQUIRE(seek.next_size() == desc.range_size(j));
+                        REQUIRE(desc.range_size(j) - desc.inputs_per_output <= 1);
+                        REQUIRE(desc.range_of_element(r.first) == j);
+                        REQUIRE(desc.range_of_element(r.second - 1) == j);
+                    }
+                }
+                while(step.range_index < ranges_size) {
+                    step.next_size();
+                }
+                CHECK(step.range_begin == input_size);
+            }
+        }
+    }
+}
+
+TEST_CASE("[n_ranges_plan] VALID for_n_ranges_linear(begin, end, plan, ...)") {
+    
+    const n_ranges_plan::table_kind tables[] = {
+        n_ranges_plan::no_table, n_ranges_plan::size_pattern_table, n_ranges_plan::boundary_table
+    };
+    
+    for(size_t input_size : {7, 27, 100, 4096, 44100}) {
+        vector<int> in(input_size);
+        for(size_t ranges_size : {1, 2, 6, 64, 1000}) {
+            if(ranges_size >= input_size) { continue; }
+            vector<pair<size_t, size_t>> expected;
+            for_n_ranges_linear(in.begin(), in.end(), ranges_size, 3, [&](size_t, auto b, auto e) {
+                expected.emplace_back(b - in.begin(), e - in.begin());
+            });
+            for(auto table : tables) {
+                const n_ranges_plan plan(input_size, ranges_size, 3, table);
+                vector<pair<size_t, size_t>> actual;
+                for_n_ranges_linear(in.begin(), in.end(), plan, [&](size_t i, auto b, auto e) {
+                    REQUIRE(i == actual.size());
+                    REQUIRE(plan.range_begin(i) == size_t(b - in.begin()));
+                    actual.emplace_back(b - in.begin(), e - in.begin());
+                });
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+    
+    SUBCASE("[n_ranges_plan] size pattern is one distribution period") {
+        const n_ranges_plan plan(4096 + 48, 64, 0);
+        CHECK(plan.sizes.size() == 4);
+        CHECK(plan.boundaries.empty());
+    }
+    
+    SUBCASE("[n_ranges_plan] INVALID input size") {
+        vector<int> in(100);
+        const n_ranges_plan plan(99, 10, 0);
+        REQUIRE_THROWS(for_n_ranges_linear(in.begin(), in.end(), plan, [](size_t, auto, auto) {}));
+    }
+}
+
+TEST_CASE("[n_ranges_linear_stepper] VALID next_size()") {
+    
+    for(size_t input_size : {7, 27, 100, 4099, 44100}) {
+        for(size_t ranges_size : {1, 2, 6, 64, 1000, 4098}) {
+            if(ranges_size >= input_size) { continue; }
+            for(size_t offset : {0, 1, 13, 9999}) {
+                const n_ranges_linear_desc desc(input_size, ranges_size, offset);
+                for(size_t first_range : {size_t(0), ranges_size/3}) {
+                    n_ranges_linear_stepper step(desc, first_range);
+                    for(size_t i = first_range; i < ranges_size; ++i) {
+                        REQUIRE(step.range_index == i);
+                        REQUIRE(step.range_begin == desc.range_begin(i));
+                        REQUIRE(step.next_size() == desc.range_size(i));
+                    }
+                    REQUIRE(step.range_begin == input_size);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("[n_ranges_linear_constants] VALID compile time partitions") {
+    
+    constexpr auto meter_bounds = n_ranges_linear_boundary_table<4096 + 48, 64, 1>();
+    static_assert(meter_bounds[0] == 0, "");
+    static_assert(meter_bounds[64] == 4096 + 48, "");
+    static_assert(n_ranges_linear_constants<27, 6>::denominator == 2, "");
+    
+    const n_ranges_linear_desc desc(4096 + 48, 64, 1);
+    for(size_t i = 0; i <= 64; ++i) {
+        CHECK(meter_bounds[i] == desc.range_begin(i));
+    }
+    
+    vector<int> in(27);
+    vector<pair<size_t, size_t>> expected, actual;
+    for_n_ranges_linear(in.begin(), in.end(), 6, 5, [&](size_t, auto b, auto e) {
+        expected.emplace_back(b - in.begin(), e - in.begin());
+    });
+    for_n_ranges_linear<27, 6, 5>(in.begin(), [&](size_t i, auto b, auto e) {
+        REQUIRE(i == actual.size());
+        actual.emplace_back(b - in.begin(), e - in.begin());
+    });
+    CHECK(actual == expected);
+}
+
+TEST_CASE("[for_n_ranges_linear] VALID forward and bidirectional iterators") {
+    
+    vector<int> intin(1000);
+    iota(intin.begin(), intin.end(), 0);
+    const list<int> listin(intin.begin(), intin.end());
+    const forward_list<int> forwardin(intin.begin(), intin.end());
+    
+    auto sum = [](auto b, auto e) -> int { return accumulate(b, e, 0); };
+    vector<int> expected, from_list, from_forward;
+    transform_n_ranges_linear(intin.begin(), intin.end(), back_inserter(expected), 73, 2, sum);
+    transform_n_ranges_linear(listin.begin(), listin.end(), back_inserter(from_list), 73, 2, sum);
+    const auto last = for_n_ranges_linear_n(forwardin.begin(), 1000, 73, 2, [&](size_t, auto b, auto e) {
+        from_forward.push_back(sum(b, e));
+    });
+    
+    CHECK(expected == from_list);
+    CHECK(expected == from_forward);
+    CHECK(last == forwardin.end());
+}
+
+TEST_CASE("[for_n_ranges_linear_expand] VALID expansion") {
+    
+    vector<int> intin(10);
+    iota(intin.begin(), intin.end(), 0);
+    
+    SUBCASE("[for_n_ranges_linear_expand] runs are distributed like for_n_ranges_linear() ranges") {
+        for(size_t ranges_size : {10, 11, 37, 1000}) {
+            for(size_t offset : {0, 3}) {
+                vector<size_t> owners;
+                for_n_ranges_linear_expand(intin.begin(), intin.end(), ranges_size, offset, [&](size_t i, auto b, auto e) {
+                    REQUIRE(i == owners.size());
+                    REQUIRE(distance(b, e) == 1);
+                    owners.push_back(*b);
+                });
+                REQUIRE(owners.size() == ranges_size);
+                REQUIRE(is_sorted(owners.begin(), owners.end()));
+                if(ranges_size > intin.size()) {
+                    const n_ranges_linear_desc runs(ranges_size, intin.size(), offset);
+                    for(size_t k = 0; k < intin.size(); ++k) {
+                        CHECK(size_t(count(owners.begin(), owners.end(), k)) == runs.range_size(k));
+                    }
+                }
+            }
+        }
+    }
+    
+    SUBCASE("[for_n_ranges_linear_expand] transform interpolates between neighbours") {
+        vector<double> out;
+        transform_n_ranges_linear_expand(intin.begin(), intin.end(), back_inserter(out), 40, 0,
+        [&](auto sample, auto next, size_t step, size_t steps) -> double {
+            const double to = next == intin.end() ? *sample : *next;
+            return *sample + (to - *sample) * double(step) / double(steps);
+        });
+        REQUIRE(out.size() == 40);
+        CHECK(is_sorted(out.begin(), out.end()));
+        CHECK(out.front() == 0.0);
+        CHECK(out[4] == 1.0);
+        CHECK(out[2] == 0.5);
+    }
+    
+    SUBCASE("[for_n_ranges_linear_scaled] compresses and expands") {
+        vector<size_t> sizes;
+        auto record = [&](size_t, auto b, auto e) { sizes.push_back(distance(b, e)); };
+        for_n_ranges_linear_scaled(intin.begin(), intin.end(), 4, 0, record);
+        CHECK(sizes == vector<size_t>({3, 2, 3, 2}));
+        sizes.clear();
+        for_n_ranges_linear_scaled(intin.begin(), intin.end(), 25, 0, record);
+        CHECK(sizes == vector<size_t>(25, 1));
+    }
+    
+    SUBCASE("[for_n_ranges_linear_expand] INVALID compression") {
+        REQUIRE_THROWS(for_n_ranges_linear_expand(intin.begin(), intin.end(), 9, 0, [](size_t, auto, auto) {}));
     }
 }
 
@@ -0,0 +1,591 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_parallel_h
+#define n_ranges_parallel_h
+
+// Requires C++17 for execution policies and std::optional.
+
+#include "n_ranges_linear.h"
+#include "n_ranges_weighted.h"
+#include "work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <optional>
+#include <algorithm>
+#include <execution>
+#include <type_traits>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template<typename ExecutionPolicy>
+using enable_if_execution_policy = std::enable_if_t<std::is_execution_policy<std::decay_t<ExecutionPolicy>>::value>;
+
+template<typename ExecutionPolicy>
+constexpr bool is_sequenced_policy() {
+    return std::is_same<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>::value;
+}
+
+// One partial result of a parallel reduction, wrapped so that a vector of them is never a bit packed std::vector<bool> shared between threads.
+template<typename T>
+struct reduce_partial {
+    T value;
+};
+
+} // END namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Visits a sequence of elements in chunks of 'n' 'equalest-possible' ranges on the threads of 'pool'.
+
+    The ranges are identical to those of the serial for_n_ranges_linear(), but they are shared out between the pool's threads, each of which seeks directly to its ranges through n_ranges_linear_desc. The order in which 'range_func' is invoked is unspecified, and 'range_func' must be safe to call concurrently.
+
+    For more about the algorithm @see: for_n_ranges_linear()
+
+    @param pool The threads to run 'range_func' on.
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename RandomIter, typename IterRangeFunc>
+void for_n_ranges_linear (
+    work_stealing_pool& pool,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    IterRangeFunc       range_func
+) {
+    assert_true(begin <= end);
+
+    const n_ranges_linear_desc desc(std::distance(begin, end), ranges_size, distribution_offset);
+    pool.for_each_index(ranges_size, [&](size_t i) {
+        const auto r = desc.range(i);
+        range_func(i, begin + r.first, begin + r.second);
+    });
+}
+
+
+/** Transforms a sequence of elements in chunks of 'n' 'equalest-possible' ranges on the threads of 'pool'.
+
+    Ranges are transformed concurrently (@see the pool for_n_ranges_linear()) but the results are written to 'output_iter' in range order. When 'output_iter' is a random access iterator each result is written straight into its slot by the thread that computed it, otherwise results are collected in indexed slots and then written in order on the calling thread.
+
+    For more about the algorithm @see: for_n_ranges_linear()
+
+    @param pool The threads to run 'range_func' on.
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param output_iter The write iterator for the results.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param range_func Transform func that takes (begin, end) and returns an arbitrary value insertable into output_iter.
+
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename RandomIter, typename OutputIter, typename IterRangeFunc>
+void transform_n_ranges_linear (
+    work_stealing_pool& pool,
+    RandomIter          begin,
+    RandomIter          end,
+    OutputIter          output_iter,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    IterRangeFunc       range_func
+) {
+    using namespace std;
+
+    typedef typename iterator_traits<OutputIter>::iterator_category output_category;
+    if constexpr (is_base_of<random_access_iterator_tag, output_category>::value) {
+        for_n_ranges_linear(pool, begin, end, ranges_size, distribution_offset, [&](size_t range_index, auto b, auto e) {
+            output_iter[range_index] = range_func(b, e);
+        });
+    }
+    else {
+        typedef decltype(range_func(begin, end)) result_type;
+        vector<optional<result_type>> results(ranges_size);
+        for_n_ranges_linear(pool, begin, end, ranges_size, distribution_offset, [&](size_t range_index, auto b, auto e) {
+            results[range_index].emplace(range_func(b, e));
+        });
+        for(auto& result : results) {
+            *output_iter++ = move(*result);
+        }
+    }
+}
+
+
+/** Visits a sequence of elements in chunks of 'n' 'equalest-possible' ranges, using an execution policy.
+
+    Parallel policies run on work_stealing_pool::shared(), @see the pool for_n_ranges_linear(). With std::execution::seq the ranges are visited serially, in order, on the calling thread.
+
+    @param policy An execution policy such as std::execution::par.
+    @see for_n_ranges_linear() for the remaining parameters, preconditions and postconditions.
+*/
+template<typename ExecutionPolicy, typename RandomIter, typename IterRangeFunc,
+    typename = detail::enable_if_execution_policy<ExecutionPolicy>>
+void for_n_ranges_linear (
+    ExecutionPolicy&&,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    IterRangeFunc       range_func
+) {
+    if constexpr (detail::is_sequenced_policy<ExecutionPolicy>()) {
+        for_n_ranges_linear(begin, end, ranges_size, distribution_offset, range_func);
+    }
+    else {
+        for_n_ranges_linear(work_stealing_pool::shared(), begin, end, ranges_size, distribution_offset, range_func);
+    }
+}
+
+
+/** Transforms a sequence of elements in chunks of 'n' 'equalest-possible' ranges, using an execution policy.
+
+    Parallel policies run on work_stealing_pool::shared() and still write results in range order, @see the pool transform_n_ranges_linear(). With std::execution::seq the ranges are transformed serially on the calling thread.
+
+    @param policy An execution policy such as std::execution::par.
+    @see transform_n_ranges_linear() for the remaining parameters, preconditions and postconditions.
+*/
+template<typename ExecutionPolicy, typename RandomIter, typename OutputIter, typename IterRangeFunc,
+    typename = detail::enable_if_execution_policy<ExecutionPolicy>>
+void transform_n_ranges_linear (
+    ExecutionPolicy&&,
+    RandomIter          begin,
+    RandomIter          end,
+    OutputIter          output_iter,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    IterRangeFunc       range_func
+) {
+    if constexpr (detail::is_sequenced_policy<ExecutionPolicy>()) {
+        transform_n_ranges_linear(begin, end, output_iter, ranges_size, distribution_offset, range_func);
+    }
+    else {
+        transform_n_ranges_linear(work_stealing_pool::shared(), begin, end, output_iter, ranges_size, distribution_offset, range_func);
+    }
+}
+
+/** Reduces a sequence of elements to one value by mapping each of 'n' 'equalest-possible' ranges on the threads of 'pool'.
+
+    The ranges are grouped into a few contiguous blocks per pool thread (themselves divided with n_ranges_linear_desc), and each block folds the results of its ranges in order, so only one partial result per block is stored rather than one per range. The partial results are then combined pairwise in a tree, keeping range order, so 'combine' must be associative but need not be commutative. Pairwise combination also keeps the rounding error of floating point sums low.
+
+    For more about the algorithm @see: reduce_n_ranges_linear()
+
+    @param pool The threads to run 'map_range' and 'combine' on.
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param identity The initial value of every block, which 'combine' leaves unchanged.
+    @param map_range Takes (begin, end) and returns a value convertible to T, must be safe to call concurrently.
+    @param combine Takes two T values and returns their associative combination, must be safe to call concurrently.
+
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename RandomIter, typename T, typename MapRangeFunc, typename CombineFunc>
+T reduce_n_ranges_linear (
+    work_stealing_pool& pool,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    T                   identity,
+    MapRangeFunc        map_range,
+    CombineFunc         combine
+) {
+    using namespace std;
+
+    assert_true(begin <= end);
+
+    const n_ranges_linear_desc desc(distance(begin, end), ranges_size, distribution_offset);
+    const size_t blocks_size = min(ranges_size, pool.size() * 4);
+    vector<detail::reduce_partial<T>> partials(blocks_size, detail::reduce_partial<T>{identity});
+    pool.for_each_index(blocks_size, [&](size_t block) {
+        size_t first_range = block, last_range = block + 1;
+        if(blocks_size < ranges_size) {
+            const n_ranges_linear_desc blocks(ranges_size, blocks_size, 0);
+            first_range = blocks.range_begin(block);
+            last_range = blocks.range_end(block);
+        }
+        n_ranges_linear_stepper step(desc, first_range);
+        auto b = begin + step.range_begin;
+        T partial = identity;
+        while(step.range_index < last_range) {
+            auto e = b + step.next_size();
+            partial = combine(move(partial), map_range(b, e));
+            b = e;
+        }
+        partials[block].value = move(partial);
+    });
+
+    for(size_t stride = 1; stride < blocks_size; stride *= 2) {
+        const size_t pairs = (blocks_size - stride + 2 * stride - 1) / (2 * stride);
+        pool.for_each_index(pairs, [&](size_t pair) {
+            const size_t left = pair * 2 * stride;
+            partials[left].value = combine(move(partials[left].value), move(partials[left + stride].value));
+        });
+    }
+    return move(partials.front().value);
+}
+
+
+/** Reduces a sequence of elements to one value by mapping each of 'n' 'equalest-possible' ranges, using an execution policy.
+
+    Parallel policies run on work_stealing_pool::shared(), @see the pool reduce_n_ranges_linear(). With std::execution::seq the ranges are mapped and combined serially, in order, on the calling thread.
+
+    @param policy An execution policy such as std::execution::par.
+    @see reduce_n_ranges_linear() for the remaining parameters, preconditions and postconditions.
+*/
+template<typename ExecutionPolicy, typename RandomIter, typename T, typename MapRangeFunc, typename CombineFunc,
+    typename = detail::enable_if_execution_policy<ExecutionPolicy>>
+T reduce_n_ranges_linear (
+    ExecutionPolicy&&,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    const size_t        distribution_offset,
+    T                   identity,
+    MapRangeFunc        map_range,
+    CombineFunc         combine
+) {
+    if constexpr (detail::is_sequenced_policy<ExecutionPolicy>()) {
+        return reduce_n_ranges_linear(begin, end, ranges_size, distribution_offset, std::move(identity), map_range, combine);
+    }
+    else {
+        return reduce_n_ranges_linear(work_stealing_pool::shared(), begin, end, ranges_size, distribution_offset, std::move(identity), map_range, combine);
+    }
+}
+
+/** Visits a sequence of elements in 'n' ranges of roughly equal total cost on the threads of 'pool'.
+
+    Element costs are evaluated in parallel, summed into running totals in one serial pass, and then every boundary is searched for independently (@see n_ranges_weighted_boundary()) before the ranges are shared out to 'range_func'. The ranges are identical to those of the serial for_n_ranges_weighted(). The order in which 'range_func' is invoked is unspecified, and 'cost_func' and 'range_func' must be safe to call concurrently.
+
+    @param pool The threads to run 'cost_func' and 'range_func' on.
+    @see for_n_ranges_weighted() for the remaining parameters, preconditions and postconditions.
+*/
+template<typename RandomIter, typename CostFunc, typename IterRangeFunc>
+void for_n_ranges_weighted (
+    work_stealing_pool& pool,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    CostFunc            cost_func,
+    IterRangeFunc       range_func
+) {
+    using namespace std;
+
+    typedef detail::element_cost_t<RandomIter, CostFunc> cost_type;
+    static_assert(is_arithmetic<cost_type>::value, "for_n_ranges_weighted() needs arithmetic costs.");
+
+    assert_true(begin <= end);
+    assert_true(ranges_size > 0);
+
+    const size_t input_size = distance(begin, end);
+    vector<cost_type> prefix(input_size + 1);
+    prefix[0] = cost_type(0);
+    pool.for_each_index(input_size, [&](size_t k) {
+        prefix[k + 1] = cost_func(begin[k]);
+    });
+    partial_sum(prefix.begin(), prefix.end(), prefix.begin());
+
+    vector<size_t> boundaries(ranges_size + 1);
+    pool.for_each_index(ranges_size + 1, [&](size_t i) {
+        boundaries[i] = n_ranges_weighted_boundary(prefix.data(), prefix.size(), ranges_size, i);
+    });
+
+    pool.for_each_index(ranges_size, [&](size_t i) {
+        range_func(i, begin + boundaries[i], begin + boundaries[i + 1]);
+    });
+}
+
+
+/** Visits a sequence of elements in 'n' ranges of roughly equal total cost, using an execution policy.
+
+    Parallel policies run on work_stealing_pool::shared(), @see the pool for_n_ranges_weighted(). With std::execution::seq this is the serial for_n_ranges_weighted().
+*/
+template<typename ExecutionPolicy, typename RandomIter, typename CostFunc, typename IterRangeFunc,
+    typename = detail::enable_if_execution_policy<ExecutionPolicy>>
+void for_n_ranges_weighted (
+    ExecutionPolicy&&,
+    RandomIter          begin,
+    RandomIter          end,
+    const size_t        ranges_size,
+    CostFunc            cost_func,
+    IterRangeFunc       range_func
+) {
+    if constexpr (detail::is_sequenced_policy<ExecutionPolicy>()) {
+        for_n_ranges_weighted(begin, end, ranges_size, cost_func, range_func);
+    }
+    else {
+        for_n_ranges_weighted(work_stealing_pool::shared(), begin, end, ranges_size, cost_func, range_func);
+    }
+}
+
+/** Measures the relative throughput of 'workers_size' threads running a kernel side by side, for use as weights.
+
+    Starts one thread per worker, all released at once so that they compete for shared resources as they will in real work, and has thread 't' call 'kernel(t)' 'repeats' times. A kernel can pin its thread to worker 't's core on the first call. The result is calls per second for each worker, suitable for for_n_ranges_proportional() on hybrid (performance and efficiency core) or mixed generation machines.
+
+    @param workers_size The number of workers to measure.
+    @param repeats How many times each worker calls 'kernel'.
+    @param kernel A representative piece of work taking the worker index.
+    @return The measured throughput of each worker.
+*/
+template<typename WorkerKernel>
+std::vector<double> n_ranges_calibrate(const size_t workers_size, const size_t repeats, WorkerKernel kernel) {
+    using namespace std;
+
+    assert_true(workers_size > 0 and repeats > 0);
+
+    vector<double> throughput(workers_size);
+    atomic<size_t> ready(0);
+    atomic<bool> go(false);
+
+    vector<thread> threads;
+    threads.reserve(workers_size);
+    for(size_t t = 0; t < workers_size; ++t) {
+        threads.emplace_back([&, t]() {
+            ++ready;
+            while(not go) {
+                this_thread::yield();
+            }
+            const auto start = chrono::steady_clock::now();
+            for(size_t r = 0; r < repeats; ++r) {
+                kernel(t);
+            }
+            const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            throughput[t] = double(repeats) / max(elapsed.count(), 1e-9);
+        });
+    }
+    while(ready < workers_size) {
+        this_thread::yield();
+    }
+    go = true;
+    for(auto& t : threads) {
+        t.join();
+    }
+    return throughput;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[n_ranges_parallel] VALID for_n_ranges_linear(policy, ...)") {
+
+    vector<int> intin(10007);
+    iota(intin.begin(), intin.end(), 0);
+
+    SUBCASE("[n_ranges_parallel] every range visited once with serial bounds") {
+        const size_t ranges_size = 997;
+        vector<pair<size_t, size_t>> serial(ranges_size), parallel(ranges_size);
+        vector<atomic<int>> visits(ranges_size);
+
+        for_n_ranges_linear(intin.begin(), intin.end(), ranges_size, 3, [&](size_t i, auto b, auto e) {
+            serial[i] = make_pair(size_t(b - intin.begin()), size_t(e - intin.begin()));
+        });
+        work_stealing_pool pool(3);
+        for_n_ranges_linear(pool, intin.begin(), intin.end(), ranges_size, 3, [&](size_t i, auto b, auto e) {
+            parallel[i] = make_pair(size_t(b - intin.begin()), size_t(e - intin.begin()));
+            ++visits[i];
+        });
+
+        CHECK(serial == parallel);
+        CHECK(all_of(visits.begin(), visits.end(), [](auto const& v) { return v == 1; }));
+    }
+
+    SUBCASE("[n_ranges_parallel] exceptions propagate to the caller") {
+        REQUIRE_THROWS(for_n_ranges_linear(execution::par, intin.begin(), intin.end(), 100, 0, [](size_t i, auto, auto) {
+            if(i == 42) { throw runtime_error("range 42"); }
+        }));
+    }
+}
+
+TEST_CASE("[n_ranges_parallel] VALID transform_n_ranges_linear(policy, ...)") {
+
+    vector<int> intin(10007);
+    iota(intin.begin(), intin.end(), 0);
+    auto sum = [](auto b, auto e) -> long { return accumulate(b, e, 0L); };
+
+    vector<long> serial;
+    transform_n_ranges_linear(intin.begin(), intin.end(), back_inserter(serial), 321, 1, sum);
+
+    SUBCASE("[n_ranges_parallel] output iterator results are in range order") {
+        vector<long> parallel;
+        transform_n_ranges_linear(execution::par, intin.begin(), intin.end(), back_inserter(parallel), 321, 1, sum);
+        CHECK(serial == parallel);
+    }
+
+    SUBCASE("[n_ranges_parallel] random access results are in range order") {
+        vector<long> parallel(321);
+        transform_n_ranges_linear(execution::par_unseq, intin.begin(), intin.end(), parallel.begin(), 321, 1, sum);
+        CHECK(serial == parallel);
+    }
+
+    SUBCASE("[n_ranges_parallel] pool results are in range order") {
+        work_stealing_pool pool(3);
+        vector<long> parallel;
+        transform_n_ranges_linear(pool, intin.begin(), intin.end(), back_inserter(parallel), 321, 1, sum);
+        CHECK(serial == parallel);
+    }
+
+    SUBCASE("[n_ranges_parallel] sequenced policy matches serial") {
+        vector<long> sequenced;
+        transform_n_ranges_linear(execution::seq, intin.begin(), intin.end(), back_inserter(sequenced), 321, 1, sum);
+        CHECK(serial == sequenced);
+    }
+}
+
+TEST_CASE("[n_ranges_parallel] VALID reduce_n_ranges_linear(policy, ...)") {
+
+    vector<long> in(100003);
+    iota(in.begin(), in.end(), 0L);
+    work_stealing_pool pool(3);
+    auto sum = [](auto b, auto e) { return accumulate(b, e, 0L); };
+    auto plus = [](long x, long y) { return x + y; };
+    const long expected = accumulate(in.begin(), in.end(), 0L);
+
+    SUBCASE("[n_ranges_parallel] sums match for any number of ranges") {
+        for(size_t ranges_size : {1, 2, 3, 15, 16, 17, 1000, 100002}) {
+            CHECK(reduce_n_ranges_linear(pool, in.begin(), in.end(), ranges_size, 3, 0L, sum, plus) == expected);
+            CHECK(reduce_n_ranges_linear(execution::seq, in.begin(), in.end(), ranges_size, 3, 0L, sum, plus) == expected);
+            CHECK(reduce_n_ranges_linear(execution::par, in.begin(), in.end(), ranges_size, 3, 0L, sum, plus) == expected);
+        }
+    }
+
+    SUBCASE("[n_ranges_parallel] bool results are combined without sharing bits") {
+        for(size_t ranges_size : {1, 17, 1000}) {
+            const bool any_big = reduce_n_ranges_linear(pool, in.begin(), in.end(), ranges_size, 0, false,
+                [](auto b, auto e) { return any_of(b, e, [](long x) { return x > 100000; }); },
+                [](bool x, bool y) { return x or y; });
+            const bool all_small = reduce_n_ranges_linear(pool, in.begin(), in.end(), ranges_size, 0, true,
+                [](auto b, auto e) { return all_of(b, e, [](long x) { return x < 100000; }); },
+                [](bool x, bool y) { return x and y; });
+            CHECK(any_big);
+            CHECK(not all_small);
+        }
+    }
+
+    SUBCASE("[n_ranges_parallel] range order is kept for non commutative combines") {
+        vector<size_t> expected_begins;
+        for_n_ranges_linear(in.begin(), in.end(), 777, 1, [&](size_t, auto b, auto) {
+            expected_begins.push_back(b - in.begin());
+        });
+        const auto begins = reduce_n_ranges_linear(pool, in.begin(), in.end(), 777, 1, vector<size_t>(),
+            [&](auto b, auto) { return vector<size_t>(1, b - in.begin()); },
+            [](vector<size_t> x, vector<size_t> const& y) { x.insert(x.end(), y.begin(), y.end()); return x; });
+        CHECK(begins == expected_begins);
+    }
+
+    SUBCASE("[n_ranges_parallel] INVALID exceptions reach the caller") {
+        REQUIRE_THROWS(reduce_n_ranges_linear(pool, in.begin(), in.end(), 100, 0, 0L,
+            [](auto, auto) -> long { throw runtime_error("map"); }, plus));
+    }
+}
+
+TEST_CASE("[n_ranges_parallel] VALID for_n_ranges_weighted(pool, ...)") {
+
+    vector<int> tasks(10007);
+    iota(tasks.begin(), tasks.end(), 0);
+    auto cost = [](int task) { return task % 7 == 0 ? 50.0 : 1.0; };
+
+    vector<pair<size_t, size_t>> serial, parallel(13);
+    for_n_ranges_weighted(tasks.begin(), tasks.end(), 13, cost, [&](size_t, auto b, auto e) {
+        serial.emplace_back(b - tasks.begin(), e - tasks.begin());
+    });
+    work_stealing_pool pool(3);
+    for_n_ranges_weighted(pool, tasks.begin(), tasks.end(), 13, cost, [&](size_t i, auto b, auto e) {
+        parallel[i] = make_pair(size_t(b - tasks.begin()), size_t(e - tasks.begin()));
+    });
+    CHECK(serial == parallel);
+}
+
+TEST_CASE("[n_ranges_parallel] VALID n_ranges_calibrate(...)") {
+
+    atomic<size_t> calls(0);
+    const auto weights = n_ranges_calibrate(3, 100, [&](size_t) {
+        volatile double x = 1.0;
+        for(int n = 0; n < 1000; ++n) { x = x * 1.0000001; }
+        ++calls;
+    });
+    REQUIRE(weights.size() == 3);
+    CHECK(calls == 300);
+    CHECK(all_of(weights.begin(), weights.end(), [](double w) { return w > 0.0; }));
+
+    vector<int> tasks(1000);
+    size_t covered = 0;
+    for_n_ranges_proportional(tasks.begin(), tasks.end(), weights.begin(), weights.end(), [&](size_t, auto b, auto e) {
+        covered += distance(b, e);
+    });
+    CHECK(covered == tasks.size());
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_parallel_h
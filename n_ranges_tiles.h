@@ -0,0 +1,310 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_tiles_h
+#define n_ranges_tiles_h
+
+#include "n_ranges_linear.h"
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// The order in which tiles are visited.
+enum class n_ranges_tile_order {
+    row_major,  // The last dimension varies fastest, as in a C array or std::layout_right mdspan.
+    morton      // Z-order, so that tiles visited close in time are close in space in every dimension.
+};
+
+
+/// One tile of an N dimensional partition, in element coordinates of each dimension.
+template<size_t Rank>
+struct n_ranges_linear_tile {
+    std::array<size_t, Rank> index; // Tile coordinates, one per dimension.
+    std::array<size_t, Rank> begin; // The first element of the tile in each dimension.
+    std::array<size_t, Rank> end;   // One past the last element of the tile in each dimension.
+};
+
+
+namespace detail {
+
+template<size_t Rank, typename TileFunc>
+class tile_visitor {
+public:
+    tile_visitor(std::array<size_t, Rank> const& extents, std::array<size_t, Rank> const& tiles, const size_t distribution_offset, TileFunc& tile_func)
+    : tiles_(tiles)
+    , tile_func_(tile_func) {
+        for(size_t d = 0; d < Rank; ++d) {
+            const n_ranges_linear_desc desc(extents[d], tiles[d], distribution_offset);
+            n_ranges_linear_stepper step(desc);
+            boundaries_[d].reserve(tiles[d] + 1);
+            boundaries_[d].push_back(0);
+            while(step.range_index < desc.ranges_size) {
+                step.next_size();
+                boundaries_[d].push_back(step.range_begin);
+            }
+        }
+    }
+
+    void row_major() {
+        std::array<size_t, Rank> index = {};
+        for(;;) {
+            visit(index);
+            size_t d = Rank;
+            while(d > 0 and ++index[d - 1] == tiles_[d - 1]) {
+                index[--d] = 0;
+            }
+            if(d == 0) {
+                return;
+            }
+        }
+    }
+
+    void morton() {
+        const size_t widest = *std::max_element(tiles_.begin(), tiles_.end());
+        size_t level = 0;
+        while((size_t(2) << level) < widest) {
+            ++level;
+        }
+        const std::array<size_t, Rank> origin = {};
+        if(widest == 1) {
+            visit(origin);
+        }
+        else {
+            morton(origin, level);
+        }
+    }
+
+private:
+    // Visits the 2^Rank children, each '2^level' tiles wide, of the cube at 'origin', skipping those wholly outside the partition.
+    void morton(std::array<size_t, Rank> const& origin, const size_t level) {
+        for(size_t child = 0; child < (size_t(1) << Rank); ++child) {
+            std::array<size_t, Rank> corner = origin;
+            bool inside = true;
+            for(size_t d = 0; d < Rank; ++d) {
+                corner[d] += ((child >> (Rank - 1 - d)) & 1) << level;
+                inside = inside and corner[d] < tiles_[d];
+            }
+            if(not inside) {
+                continue;
+            }
+            if(level == 0) {
+                visit(corner);
+            }
+            else {
+                morton(corner, level - 1);
+            }
+        }
+    }
+
+    void visit(std::array<size_t, Rank> const& index) {
+        n_ranges_linear_tile<Rank> tile;
+        tile.index = index;
+        for(size_t d = 0; d < Rank; ++d) {
+            tile.begin[d] = boundaries_[d][index[d]];
+            tile.end[d] = boundaries_[d][index[d] + 1];
+        }
+        tile_func_(tile);
+    }
+
+    std::array<size_t, Rank>                tiles_;
+    std::array<std::vector<size_t>, Rank>   boundaries_;
+    TileFunc&                               tile_func_;
+};
+
+} // END namespace detail
+
+
+/** Visits an N dimensional grid of elements in 'equalest-possible' tiles.
+
+    Each dimension is divided as if by for_n_ranges_linear(), so tiles differ in size by at most one element along any axis, with the remainders spread linearly. The dimensions are ordered as in a std::layout_right mdspan, with the last varying fastest in memory, so a tile of an mdspan 'm' covers 'm[y, x]' for 'y' in [tile.begin[0], tile.end[0]) and 'x' in [tile.begin[1], tile.end[1]).
+
+    Visiting in Morton order keeps consecutive tiles close together in every dimension, which helps when a tile reads a border of its neighbours (eg. filtering for a downscale), and when tiles are sized to fit in L2 the working set moves smoothly instead of streaming whole rows.
+
+    @param extents The number of elements in each dimension.
+    @param tiles The number of tiles to divide each dimension into.
+    @param distribution_offset When calculating the distribution of each dimension this offset is applied. @see for_n_ranges_linear() for more information.
+    @param tile_func The func that takes an n_ranges_linear_tile<Rank> const&.
+    @param order The order in which to visit the tiles.
+
+    PRECONDITIONS:
+        for every dimension, 0 < tiles[d] < extents[d]
+    POSTCONDITIONS:
+        every element is in exactly one tile, and every tile has been passed to tile_func once
+*/
+template<size_t Rank, typename TileFunc>
+void for_n_ranges_linear_nd (
+    std::array<size_t, Rank> const& extents,
+    std::array<size_t, Rank> const& tiles,
+    const size_t                    distribution_offset,
+    TileFunc                        tile_func,
+    const n_ranges_tile_order       order = n_ranges_tile_order::row_major
+) {
+    static_assert(Rank > 0, "for_n_ranges_linear_nd() needs at least one dimension.");
+
+    detail::tile_visitor<Rank, TileFunc> visitor(extents, tiles, distribution_offset, tile_func);
+    if(order == n_ranges_tile_order::morton) {
+        visitor.morton();
+    }
+    else {
+        visitor.row_major();
+    }
+}
+
+
+/** Visits a two dimensional grid of elements, such as an image or matrix, in 'equalest-possible' tiles.
+
+    For example, downscaling an image in tiles that stay resident in cache:
+
+        for_n_ranges_linear_2d(image.width(), image.height(), 16, 16, 0,
+        [&](size_t tile_x, size_t tile_y, auto x_range, auto y_range) {
+            downscale(image, x_range.first, x_range.second, y_range.first, y_range.second);
+        }, n_ranges_tile_order::morton);
+
+    In row major order tiles are visited along 'x' first. @see for_n_ranges_linear_nd() for more information.
+
+    @param extent_x The number of elements along x (eg. columns).
+    @param extent_y The number of elements along y (eg. rows).
+    @param tiles_x The number of tiles to divide x into.
+    @param tiles_y The number of tiles to divide y into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param tile_func The func that takes size_t tile_x, tile_y, and the [begin, end) pairs of x and y.
+    @param order The order in which to visit the tiles.
+
+    PRECONDITIONS:
+        0 < tiles_x < extent_x
+        0 < tiles_y < extent_y
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear_nd()
+*/
+template<typename TileFunc>
+void for_n_ranges_linear_2d (
+    const size_t                extent_x,
+    const size_t                extent_y,
+    const size_t                tiles_x,
+    const size_t                tiles_y,
+    const size_t                distribution_offset,
+    TileFunc                    tile_func,
+    const n_ranges_tile_order   order = n_ranges_tile_order::row_major
+) {
+    using namespace std;
+
+    const array<size_t, 2> extents = {{extent_y, extent_x}};
+    const array<size_t, 2> tiles = {{tiles_y, tiles_x}};
+    for_n_ranges_linear_nd(extents, tiles, distribution_offset, [&tile_func](n_ranges_linear_tile<2> const& tile) {
+        tile_func(tile.index[1], tile.index[0], make_pair(tile.begin[1], tile.end[1]), make_pair(tile.begin[0], tile.end[0]));
+    }, order);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[n_ranges_tiles] VALID for_n_ranges_linear_2d(...)") {
+
+    const size_t width = 640, height = 481;
+    vector<int> pixels(width * height, 0);
+    auto cover = [&](size_t, size_t, pair<size_t, size_t> x, pair<size_t, size_t> y) {
+        for(size_t row = y.first; row < y.second; ++row) {
+            for(size_t column = x.first; column < x.second; ++column) {
+                ++pixels[row * width + column];
+            }
+        }
+    };
+
+    SUBCASE("[n_ranges_tiles] row major tiles match for_n_ranges_linear() along each axis") {
+        const n_ranges_linear_desc columns(width, 7, 3), rows(height, 5, 3);
+        vector<pair<size_t, size_t>> visited;
+        for_n_ranges_linear_2d(width, height, 7, 5, 3, [&](size_t tx, size_t ty, auto x, auto y) {
+            CHECK(x == columns.range(tx));
+            CHECK(y == rows.range(ty));
+            visited.emplace_back(tx, ty);
+            cover(tx, ty, x, y);
+        });
+        REQUIRE(visited.size() == 35);
+        for(size_t k = 0; k < visited.size(); ++k) {
+            CHECK(visited[k] == make_pair(k % 7, k / 7));
+        }
+        CHECK(all_of(pixels.begin(), pixels.end(), [](int p) { return p == 1; }));
+    }
+
+    SUBCASE("[n_ranges_tiles] morton order") {
+        vector<pair<size_t, size_t>> visited;
+        for_n_ranges_linear_2d(width, height, 4, 4, 0, [&](size_t tx, size_t ty, auto, auto) {
+            visited.emplace_back(tx, ty);
+        }, n_ranges_tile_order::morton);
+        const vector<pair<size_t, size_t>> z = {
+            {0, 0}, {1, 0}, {0, 1}, {1, 1}, {2, 0}, {3, 0}, {2, 1}, {3, 1},
+            {0, 2}, {1, 2}, {0, 3}, {1, 3}, {2, 2}, {3, 2}, {2, 3}, {3, 3}};
+        CHECK(visited == z);
+
+        for_n_ranges_linear_2d(width, height, 3, 11, 1, cover, n_ranges_tile_order::morton);
+        CHECK(all_of(pixels.begin(), pixels.end(), [](int p) { return p == 1; }));
+    }
+
+    SUBCASE("[n_ranges_tiles] three dimensions") {
+        const array<size_t, 3> extents = {{9, 10, 11}};
+        vector<int> voxels(9 * 10 * 11, 0);
+        for(auto order : {n_ranges_tile_order::row_major, n_ranges_tile_order::morton}) {
+            size_t tiles = 0;
+            for_n_ranges_linear_nd(extents, array<size_t, 3>{{2, 3, 5}}, 0, [&](n_ranges_linear_tile<3> const& t) {
+                ++tiles;
+                for(size_t z = t.begin[0]; z < t.end[0]; ++z)
+                    for(size_t y = t.begin[1]; y < t.end[1]; ++y)
+                        for(size_t x = t.begin[2]; x < t.end[2]; ++x)
+                            ++voxels[(z * 10 + y) * 11 + x];
+            }, order);
+            CHECK(tiles == 30);
+        }
+        CHECK(all_of(voxels.begin(), voxels.end(), [](int v) { return v == 2; }));
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_tiles_h
@@ -0,0 +1,185 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_viewport_h
+#define n_ranges_viewport_h
+
+#include "n_ranges_linear.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A window onto the ranges of a partition of a whole sequence.
+
+    Rather than partitioning only the visible elements (which moves every boundary whenever the window moves by less than a range), a viewport selects ranges of a single global partition, so a range computed for one scroll position is identical at every other. The left edge of the window may fall inside a range, in which case 'phase' is the fraction of that range hidden to the left, and drawing is shifted by 'phase' of a column for smooth scrolling.
+*/
+struct n_ranges_linear_viewport {
+    size_t  first_range;    // Global index of the leftmost, possibly partly hidden, range.
+    size_t  ranges_size;    // Number of ranges at least partly visible.
+    double  phase;          // Fraction of 'first_range' hidden left of the window, in [0, 1).
+};
+
+
+/** Places a window 'visible_ranges' ranges wide with its left edge at element 'first_element' of the global partition 'desc'.
+
+    The window is clipped to the end of the partition.
+*/
+inline n_ranges_linear_viewport make_n_ranges_linear_viewport (
+    n_ranges_linear_desc const& desc,
+    const size_t                first_element,
+    const size_t                visible_ranges
+) {
+    assert_true(first_element < desc.input_size);
+
+    n_ranges_linear_viewport viewport;
+    viewport.first_range = desc.range_of_element(first_element);
+    const size_t hidden = first_element - desc.range_begin(viewport.first_range);
+    viewport.phase = double(hidden) / double(desc.range_size(viewport.first_range));
+    viewport.ranges_size = std::min(visible_ranges + (hidden > 0 ? 1 : 0), desc.ranges_size - viewport.first_range);
+    return viewport;
+}
+
+
+/** Visits the ranges of a global partition that are visible in a viewport.
+
+    @param begin The beginning of the whole sequence that 'desc' partitions.
+    @param desc The global partition.
+    @param viewport The visible window, @see make_n_ranges_linear_viewport().
+    @param range_func The func that takes a size_t global range_index, begin, and end iterators.
+*/
+template<typename RandomIter, typename IterRangeFunc>
+void for_n_ranges_linear_viewport (
+    RandomIter                      begin,
+    n_ranges_linear_desc const&     desc,
+    n_ranges_linear_viewport const& viewport,
+    IterRangeFunc                   range_func
+) {
+    detail::visit_range_window(begin, desc, viewport.first_range, viewport.first_range + viewport.ranges_size, range_func);
+}
+
+
+/** Visits only the ranges visible in 'current' that were not visible in 'previous'.
+
+    After a scroll, columns cached by global range index for 'previous' are still valid, so only the newly exposed edge (or edges, when the window has also grown) has to be computed. The work is proportional to the scroll distance rather than the window width.
+
+    @param begin The beginning of the whole sequence that 'desc' partitions.
+    @param desc The global partition.
+    @param previous The window already computed.
+    @param current The window to complete.
+    @param range_func The func that takes a size_t global range_index, begin, and end iterators.
+*/
+template<typename RandomIter, typename IterRangeFunc>
+void for_n_ranges_linear_exposed (
+    RandomIter                      begin,
+    n_ranges_linear_desc const&     desc,
+    n_ranges_linear_viewport const& previous,
+    n_ranges_linear_viewport const& current,
+    IterRangeFunc                   range_func
+) {
+    using namespace std;
+
+    const size_t previous_end = previous.first_range + previous.ranges_size;
+    const size_t current_end = current.first_range + current.ranges_size;
+    if(previous.ranges_size == 0 or previous_end <= current.first_range or current_end <= previous.first_range) {
+        detail::visit_range_window(begin, desc, current.first_range, current_end, range_func);
+        return;
+    }
+    detail::visit_range_window(begin, desc, current.first_range, max(current.first_range, min(current_end, previous.first_range)), range_func);
+    detail::visit_range_window(begin, desc, min(current_end, max(current.first_range, previous_end)), current_end, range_func);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[n_ranges_linear_viewport] VALID for_n_ranges_linear_viewport(...)") {
+
+    vector<int> samples(44100);
+    iota(samples.begin(), samples.end(), 0);
+    const n_ranges_linear_desc desc(samples.size(), 4000, 7);
+
+    vector<pair<size_t, size_t>> global;
+    for_n_ranges_linear(samples.begin(), samples.end(), 4000, 7, [&](size_t, auto b, auto e) {
+        global.emplace_back(b - samples.begin(), e - samples.begin());
+    });
+
+    SUBCASE("[n_ranges_linear_viewport] sliding windows see the global ranges") {
+        for(size_t first_element : {0, 1, 5, 11, 12, 20000, 44000}) {
+            const auto viewport = make_n_ranges_linear_viewport(desc, first_element, 100);
+            CHECK(viewport.phase >= 0.0);
+            CHECK(viewport.phase < 1.0);
+            size_t visited = 0;
+            for_n_ranges_linear_viewport(samples.begin(), desc, viewport, [&](size_t i, auto b, auto e) {
+                REQUIRE(i == viewport.first_range + visited++);
+                REQUIRE(global[i] == make_pair(size_t(b - samples.begin()), size_t(e - samples.begin())));
+            });
+            CHECK(visited == viewport.ranges_size);
+            CHECK(global[viewport.first_range].first <= first_element);
+            CHECK(global[viewport.first_range].second > first_element);
+        }
+    }
+
+    SUBCASE("[n_ranges_linear_viewport] scrolling only exposes the new edge") {
+        const auto previous = make_n_ranges_linear_viewport(desc, 1000, 100);
+        for(size_t first_element : {990, 1003, 1100, 1500, 30000}) {
+            const auto current = make_n_ranges_linear_viewport(desc, first_element, 100);
+            vector<size_t> exposed;
+            for_n_ranges_linear_exposed(samples.begin(), desc, previous, current, [&](size_t i, auto b, auto e) {
+                REQUIRE(global[i] == make_pair(size_t(b - samples.begin()), size_t(e - samples.begin())));
+                exposed.push_back(i);
+            });
+            for(size_t i = current.first_range; i < current.first_range + current.ranges_size; ++i) {
+                const bool was_visible = i >= previous.first_range and i < previous.first_range + previous.ranges_size;
+                CHECK(was_visible != (find(exposed.begin(), exposed.end(), i) != exposed.end()));
+            }
+        }
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_viewport_h
@@ -0,0 +1,296 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef n_ranges_weighted_h
+#define n_ranges_weighted_h
+
+#include "n_ranges_linear.h"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Finds the begin of range 'range_index' when elements are divided by cost rather than by count.
+
+    'prefix' holds the running total of element costs, with 'prefix[0] == 0' and 'prefix[k]' the cost of the first 'k' elements. The boundary is the element index whose running total is nearest to 'range_index/ranges_size' of the total cost, preferring the lower index on ties. Each boundary is found with a binary search independent of the others, so boundaries can be searched for in parallel.
+
+    @param prefix The running cost totals, 'elements + 1' entries.
+    @param prefix_size The number of running totals.
+    @param ranges_size The number of ranges.
+    @param range_index The range to find the begin of, range_index == ranges_size gives the end of the input.
+*/
+template<typename Cost>
+size_t n_ranges_weighted_boundary(Cost const* prefix, const size_t prefix_size, const size_t ranges_size, const size_t range_index) {
+    assert_true(prefix_size > 0 and range_index <= ranges_size);
+
+    if(range_index == 0) {
+        return 0;
+    }
+    if(range_index == ranges_size) {
+        return prefix_size - 1;
+    }
+
+    const double target = double(prefix[prefix_size - 1]) * double(range_index) / double(ranges_size);
+    const size_t above = std::lower_bound(prefix, prefix + prefix_size, target,
+        [](Cost const& cost, double t) { return double(cost) < t; }) - prefix;
+    if(above > 0 and target - double(prefix[above - 1]) <= double(prefix[above]) - target) {
+        return above - 1;
+    }
+    return above;
+}
+
+
+namespace detail {
+
+template<typename RandomIter, typename CostFunc>
+using element_cost_t = std::decay_t<decltype(std::declval<CostFunc&>()(*std::declval<RandomIter>()))>;
+
+} // END namespace detail
+
+
+/** Visits a sequence of elements in 'n' ranges of roughly equal total cost.
+
+    Like for_n_ranges_linear(), the ranges are contiguous and in order, but they balance the sum of 'cost_func(element)' instead of the number of elements. For example, distributing tasks of uneven size among workers:
+
+        for_n_ranges_weighted(tasks.begin(), tasks.end(), workers.size(),
+        [](auto const& task) { return task.estimated_cost(); },
+        [&workers](size_t range_index, auto begin, auto end) {
+            workers[range_index].schedule(begin, end);
+        });
+
+    The running cost totals are computed in one pass, then each boundary is placed where the running total is nearest its share of the total cost (@see n_ranges_weighted_boundary()). A range is only empty when a single element costs more than a range's share. For a parallel version @see n_ranges_parallel.h.
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param ranges_size The number of ranges to divide this sequence into.
+    @param cost_func Takes an element and returns its non-negative arithmetic cost.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+
+    PRECONDITIONS:
+        begin <= end
+        ranges_size > 0
+    POSTCONDITIONS:
+        every element has been ordered into a range and passed to range_func
+*/
+template<typename RandomIter, typename CostFunc, typename IterRangeFunc>
+void for_n_ranges_weighted (
+    RandomIter      begin,
+    RandomIter      end,
+    const size_t    ranges_size,
+    CostFunc        cost_func,
+    IterRangeFunc   range_func
+) {
+    using namespace std;
+
+    typedef detail::element_cost_t<RandomIter, CostFunc> cost_type;
+    static_assert(is_arithmetic<cost_type>::value, "for_n_ranges_weighted() needs arithmetic costs.");
+
+    assert_true(begin <= end);
+    assert_true(ranges_size > 0);
+
+    const size_t input_size = distance(begin, end);
+    vector<cost_type> prefix(input_size + 1);
+    prefix[0] = cost_type(0);
+    for(size_t k = 0; k < input_size; ++k) {
+        prefix[k + 1] = prefix[k] + cost_func(begin[k]);
+    }
+
+    size_t b = 0;
+    for(size_t i = 0; i < ranges_size; ++i) {
+        const size_t e = n_ranges_weighted_boundary(prefix.data(), prefix.size(), ranges_size, i + 1);
+        range_func(i, begin + b, begin + e);
+        b = e;
+    }
+}
+
+
+/** Visits a sequence of elements in ranges sized in proportion to per-range weights.
+
+    Where for_n_ranges_linear() gives every range the same share, here range 'i' receives 'weights[i]/sum(weights)' of the elements, for example to keep fast and slow cores busy for the same time:
+
+        const auto weights = n_ranges_calibrate(workers.size(), 1000, benchmark_kernel);
+        for_n_ranges_proportional(tasks.begin(), tasks.end(), weights.begin(), weights.end(),
+        [&workers](size_t range_index, auto begin, auto end) {
+            workers[range_index].schedule(begin, end);
+        });
+
+    Each boundary is the running share of the elements rounded to the nearest element, so rounding remainders are spread linearly across the ranges as in for_n_ranges_linear(), rather than collecting at either end, and every range is within one element of its exact share. Equal weights therefore give ranges of equal size +/-1, although the larger ranges may be placed differently than by for_n_ranges_linear().
+
+    @param begin The beginning of the input range.
+    @param end The end of the input range.
+    @param weights_begin The beginning of the non-negative arithmetic weights, one per range.
+    @param weights_end The end of the weights.
+    @param range_func The func that takes a size_t range_index, begin, and end iterators.
+
+    PRECONDITIONS:
+        begin <= end
+        at least one weight, and a positive sum of weights
+    POSTCONDITIONS:
+        every element has been ordered into a range and passed to range_func
+*/
+template<typename RandomIter, typename WeightIter, typename IterRangeFunc>
+void for_n_ranges_proportional (
+    RandomIter      begin,
+    RandomIter      end,
+    WeightIter      weights_begin,
+    WeightIter      weights_end,
+    IterRangeFunc   range_func
+) {
+    using namespace std;
+
+    assert_true(begin <= end);
+    assert_true(weights_begin != weights_end);
+
+    double total = 0.0;
+    for(auto w = weights_begin; w != weights_end; ++w) {
+        assert_true(*w >= 0);
+        total += double(*w);
+    }
+    assert_true(total > 0.0);
+
+    const size_t input_size = distance(begin, end);
+    double running = 0.0;
+    size_t b = 0, i = 0;
+    for(auto w = weights_begin; w != weights_end; ++w, ++i) {
+        running += double(*w);
+        size_t e = input_size;
+        if(next(w) != weights_end) {
+            e = min(input_size, max(b, size_t(running * double(input_size) / total + 0.5)));
+        }
+        range_func(i, begin + b, begin + e);
+        b = e;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[for_n_ranges_weighted] VALID for_n_ranges_weighted(...)") {
+
+    vector<int> tasks(1000);
+    iota(tasks.begin(), tasks.end(), 0);
+    auto cost = [](int task) -> size_t { return task % 10 == 0 ? 100 : 1; };
+    const size_t total = 100 * 100 + 900;
+
+    vector<pair<size_t, size_t>> ranges;
+    vector<size_t> costs;
+    for_n_ranges_weighted(tasks.begin(), tasks.end(), 8, cost, [&](size_t i, auto b, auto e) {
+        REQUIRE(i == ranges.size());
+        ranges.emplace_back(b - tasks.begin(), e - tasks.begin());
+        costs.push_back(accumulate(b, e, size_t(0), [&](size_t sum, int task) { return sum + cost(task); }));
+    });
+
+    REQUIRE(ranges.size() == 8);
+    CHECK(ranges.front().first == 0);
+    CHECK(ranges.back().second == tasks.size());
+    for(size_t i = 1; i < ranges.size(); ++i) {
+        CHECK(ranges[i].first == ranges[i - 1].second);
+    }
+    for(size_t c : costs) {
+        CHECK(c <= total / 8 + 100);
+        CHECK(c + 100 >= total / 8);
+    }
+
+    SUBCASE("[for_n_ranges_weighted] uniform costs match the linear count split within one element") {
+        vector<pair<size_t, size_t>> weighted;
+        for_n_ranges_weighted(tasks.begin(), tasks.end(), 7, [](int) { return 1; }, [&](size_t, auto b, auto e) {
+            weighted.emplace_back(b - tasks.begin(), e - tasks.begin());
+        });
+        for_n_ranges_linear(tasks.begin(), tasks.end(), 7, 0, [&](size_t i, auto b, auto) {
+            CHECK(abs(long(weighted[i].first) - long(b - tasks.begin())) <= 1);
+        });
+    }
+
+    SUBCASE("[for_n_ranges_weighted] one heavy element leaves empty ranges") {
+        vector<size_t> sizes;
+        for_n_ranges_weighted(tasks.begin(), tasks.begin() + 3, 4, [](int t) { return t == 1 ? 1000.0 : 1.0; },
+        [&](size_t, auto b, auto e) { sizes.push_back(distance(b, e)); });
+        CHECK(sizes.size() == 4);
+        CHECK(accumulate(sizes.begin(), sizes.end(), size_t(0)) == 3);
+    }
+}
+
+TEST_CASE("[for_n_ranges_proportional] VALID for_n_ranges_proportional(...)") {
+
+    vector<int> tasks(100);
+    iota(tasks.begin(), tasks.end(), 0);
+    vector<size_t> sizes;
+    auto record = [&](size_t i, auto b, auto e) {
+        REQUIRE(i == sizes.size());
+        sizes.push_back(distance(b, e));
+    };
+
+    SUBCASE("[for_n_ranges_proportional] exact shares") {
+        const vector<double> weights = {2.0, 1.0, 1.0};
+        for_n_ranges_proportional(tasks.begin(), tasks.end(), weights.begin(), weights.end(), record);
+        CHECK(sizes == vector<size_t>({50, 25, 25}));
+    }
+
+    SUBCASE("[for_n_ranges_proportional] equal weights are equal +/-1") {
+        const vector<int> weights(7, 3);
+        for_n_ranges_proportional(tasks.begin(), tasks.end(), weights.begin(), weights.end(), record);
+        REQUIRE(sizes.size() == 7);
+        CHECK(accumulate(sizes.begin(), sizes.end(), size_t(0)) == 100);
+        const auto minmax = minmax_element(sizes.begin(), sizes.end());
+        CHECK(*minmax.second - *minmax.first <= 1);
+    }
+
+    SUBCASE("[for_n_ranges_proportional] every range within one element of its share") {
+        const vector<double> weights = {3.7, 1.1, 0.0, 9.2, 2.5};
+        for_n_ranges_proportional(tasks.begin(), tasks.end(), weights.begin(), weights.end(), record);
+        const double total = accumulate(weights.begin(), weights.end(), 0.0);
+        for(size_t i = 0; i < weights.size(); ++i) {
+            CHECK(abs(double(sizes[i]) - 100.0 * weights[i] / total) < 1.0);
+        }
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // n_ranges_weighted_h
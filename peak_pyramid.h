@@ -0,0 +1,440 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef peak_pyramid_h
+#define peak_pyramid_h
+
+#include "n_ranges_linear.h"
+#include "range_stats.h"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A multi-resolution summary of a sample buffer, for drawing it at any width without reading every sample.
+
+    Level 0 holds the peak_summary of every block of 'block_size' samples, and each level above it merges 'decimation' nodes of the level below, up to a single root, for about 'samples_size/block_size * decimation/(decimation - 1)' nodes in all. It is built once per buffer in one pass, with the SIMD kernel of range_stats().
+
+        const peak_pyramid<short> pyramid(samples.data(), samples.size());
+        vector<peak_summary<short>> columns;
+        pyramid.columns(back_inserter(columns), width, 0); // any width, on every zoom
+
+    Any run of samples is summarized exactly by scanning the less than one block of samples at each end, and merging the coarsest nodes that fit between them, at most '2 * (decimation - 1)' per level. A column therefore costs O(block_size + decimation * log(samples per column)) whatever the zoom, and a whole view costs O(pixels) rather than O(samples). The columns are identical to those of for_n_ranges_linear() over the raw samples.
+
+    The pyramid refers to the samples rather than copying them, so the buffer must outlive it and must only move through append(). Samples edited in place are resummarized with update(), and peak_columns keeps the columns of a view current as the samples change.
+*/
+template<typename T>
+class peak_pyramid {
+public:
+    /** @param samples The samples to summarize.
+        @param samples_size The number of samples.
+        @param block_size The number of samples summarized by each node of level 0.
+        @param decimation The number of nodes of each level merged into a node of the level above.
+
+        PRECONDITIONS:
+            samples_size > 0
+            block_size > 0
+            decimation > 1
+    */
+    peak_pyramid(T const* samples, const size_t samples_size, const size_t block_size = 64, const size_t decimation = 4)
+    : samples_(samples)
+    , samples_size_(samples_size)
+    , block_size_(block_size)
+    , decimation_(decimation) {
+        assert_true(samples_size > 0 and block_size > 0 and decimation > 1);
+
+        levels_.emplace_back((samples_size + block_size - 1) / block_size);
+        rebuild_blocks(0, levels_[0].size());
+    }
+
+    /** Resummarizes samples [first, last) after they were changed in place.
+
+        Only the blocks holding the changed samples and their ancestors are recomputed, O(last - first + decimation * log(samples_size)).
+
+        PRECONDITIONS:
+            first < last <= size()
+    */
+    void update(const size_t first, const size_t last) {
+        assert_true(first < last and last <= samples_size_);
+        rebuild_blocks(first / block_size_, (last + block_size_ - 1) / block_size_);
+    }
+
+    /** Extends the pyramid after samples were appended to the buffer, which may have moved.
+
+        Only the last partial block, the new blocks, and their ancestors are recomputed, so keeping the pyramid of a recording current costs O(new samples) rather than O(samples_size).
+
+        @param samples The start of the buffer, the first size() samples of which are unchanged.
+        @param samples_size The new number of samples.
+
+        PRECONDITIONS:
+            samples_size >= size()
+    */
+    void append(T const* samples, const size_t samples_size) {
+        assert_true(samples_size >= samples_size_);
+
+        const size_t first_block = samples_size_ / block_size_;
+        samples_ = samples;
+        samples_size_ = samples_size;
+        levels_[0].resize((samples_size + block_size_ - 1) / block_size_);
+        rebuild_blocks(first_block, levels_[0].size());
+    }
+
+    /// The number of samples summarized.
+    size_t size() const {
+        return samples_size_;
+    }
+
+    /// The number of levels, including the root.
+    size_t levels_size() const {
+        return levels_.size();
+    }
+
+    /// The nodes of level 'level_index', node 'i' summarizes samples [i * node_size(level_index), (i + 1) * node_size(level_index)).
+    std::vector<peak_summary<T>> const& level(const size_t level_index) const {
+        return levels_[level_index];
+    }
+
+    /// The number of samples summarized by each node of level 'level_index' (the last node may hold fewer).
+    size_t node_size(const size_t level_index) const {
+        size_t size = block_size_;
+        for(size_t k = 0; k < level_index; ++k) {
+            size *= decimation_;
+        }
+        return size;
+    }
+
+    /// The exact summary of samples [first, last).
+    peak_summary<T> summarize(size_t first, size_t last) const {
+        assert_true(first < last and last <= samples_size_);
+
+        peak_summary<T> summary;
+        size_t b = (first + block_size_ - 1) / block_size_;
+        size_t e = last / block_size_;
+        if(b >= e) {
+            summary.merge(peak_summary<T>::of(samples_ + first, samples_ + last));
+            return summary;
+        }
+        if(first < b * block_size_) {
+            summary.merge(peak_summary<T>::of(samples_ + first, samples_ + b * block_size_));
+        }
+        if(e * block_size_ < last) {
+            summary.merge(peak_summary<T>::of(samples_ + e * block_size_, samples_ + last));
+        }
+
+        // Climb while the remaining nodes are aligned to the level above, merging the unaligned nodes at each end.
+        for(size_t k = 0; b < e; ++k) {
+            auto const& nodes = levels_[k];
+            if(k + 1 == levels_.size()) {
+                for(; b < e; ++b) {
+                    summary.merge(nodes[b]);
+                }
+                break;
+            }
+            for(; b < e and b % decimation_ != 0; ++b) {
+                summary.merge(nodes[b]);
+            }
+            for(; b < e and e % decimation_ != 0; --e) {
+                summary.merge(nodes[e - 1]);
+            }
+            b /= decimation_;
+            e /= decimation_;
+        }
+        return summary;
+    }
+
+    /** Writes the summary of each of 'ranges_size' columns to 'output_iter', in order.
+
+        The columns are exactly the ranges for_n_ranges_linear() would divide the samples into. @see for_n_ranges_linear() for the parameters.
+    */
+    template<typename OutputIter>
+    OutputIter columns(OutputIter output_iter, const size_t ranges_size, const size_t distribution_offset) const {
+        const n_ranges_linear_desc desc(samples_size_, ranges_size, distribution_offset);
+        n_ranges_linear_stepper step(desc);
+        while(step.range_index < ranges_size) {
+            const size_t b = step.range_begin;
+            *output_iter++ = summarize(b, b + step.next_size());
+        }
+        return output_iter;
+    }
+
+private:
+    // Recomputes blocks [b, e) of level 0 from the samples, and their ancestors, growing the levels above to fit level 0.
+    void rebuild_blocks(size_t b, size_t e) {
+        for(size_t i = b; i < e; ++i) {
+            const size_t first = i * block_size_;
+            levels_[0][i] = peak_summary<T>::of(samples_ + first, samples_ + std::min(samples_size_, first + block_size_));
+        }
+        for(size_t k = 0; levels_[k].size() > 1; ++k) {
+            const size_t parents_size = (levels_[k].size() + decimation_ - 1) / decimation_;
+            if(k + 1 == levels_.size()) {
+                levels_.emplace_back(parents_size);
+            }
+            else {
+                levels_[k + 1].resize(parents_size);
+            }
+            b /= decimation_;
+            e = (e + decimation_ - 1) / decimation_;
+            for(size_t parent = b; parent < e; ++parent) {
+                const size_t last_child = std::min(levels_[k].size(), (parent + 1) * decimation_);
+                peak_summary<T> node;
+                for(size_t child = parent * decimation_; child < last_child; ++child) {
+                    node.merge(levels_[k][child]);
+                }
+                levels_[k + 1][parent] = node;
+            }
+        }
+    }
+
+    T const*                                    samples_;
+    size_t                                      samples_size_;
+    size_t                                      block_size_;
+    size_t                                      decimation_;
+    std::vector<std::vector<peak_summary<T>>>   levels_;
+};
+
+
+/** The columns of one partition of a changing sample buffer, kept current by recomputing only the columns that change.
+
+    The columns are the ranges of 'desc', exactly as for_n_ranges_linear() would divide a buffer of 'desc.input_size' samples. The partition is fixed when the columns are made, so a growing recording is given its expected final length up front, as with n_ranges_linear_accumulator: columns past the samples summarized so far are empty, and the column at the end of the samples holds those it has so far.
+
+        peak_pyramid<short> pyramid(recording.data(), recording.size());
+        peak_columns<short> view(pyramid, n_ranges_linear_desc(expected_samples, width, 0));
+        ...
+        const size_t old_size = recording.size();
+        recording.insert(recording.end(), block.begin(), block.end());
+        pyramid.append(recording.data(), recording.size());
+        const auto dirty = view.refresh(old_size, recording.size()); // redraw columns [dirty.first, dirty.second)
+
+    After an edit of samples [first, last) and pyramid.update(first, last), refresh(first, last) recomputes the columns overlapping the edit. A refresh costs O(changed columns * log(samples per column)), whatever the size of the buffer.
+*/
+template<typename T>
+class peak_columns {
+public:
+    /** @param pyramid The summary of the samples, which must outlive the columns.
+        @param desc The partition of the samples into columns.
+
+        PRECONDITIONS:
+            pyramid.size() <= desc.input_size
+    */
+    peak_columns(peak_pyramid<T> const& pyramid, n_ranges_linear_desc const& desc)
+    : pyramid_(&pyramid)
+    , desc_(desc)
+    , columns_(desc.ranges_size) {
+        refresh(0, pyramid.size());
+    }
+
+    /** Recomputes the columns overlapping samples [first, last) from the pyramid, returning the indexes [first_column, last_column) recomputed.
+
+        PRECONDITIONS:
+            first <= last <= pyramid.size() <= desc().input_size
+    */
+    std::pair<size_t, size_t> refresh(const size_t first, const size_t last) {
+        const size_t samples_size = pyramid_->size();
+        assert_true(first <= last and last <= samples_size and samples_size <= desc_.input_size);
+        if(first == last) {
+            return std::make_pair(size_t(0), size_t(0));
+        }
+
+        const size_t first_column = desc_.range_of_element(first);
+        const size_t last_column = desc_.range_of_element(last - 1) + 1;
+        n_ranges_linear_stepper step(desc_, first_column);
+        while(step.range_index < last_column) {
+            const size_t i = step.range_index;
+            const size_t b = step.range_begin;
+            const size_t e = std::min(samples_size, b + step.next_size());
+            columns_[i] = b < e ? pyramid_->summarize(b, e) : peak_summary<T>();
+        }
+        return std::make_pair(first_column, last_column);
+    }
+
+    /// The partition of the samples into columns.
+    n_ranges_linear_desc const& desc() const {
+        return desc_;
+    }
+
+    /// The summary of every column, in order.
+    std::vector<peak_summary<T>> const& columns() const {
+        return columns_;
+    }
+
+private:
+    peak_pyramid<T> const*          pyramid_;
+    n_ranges_linear_desc            desc_;
+    std::vector<peak_summary<T>>    columns_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+template<typename T>
+void check_summary(vector<T> const& samples, peak_summary<T> const& summary, const size_t first, const size_t last) {
+    const auto minmax = minmax_element(samples.begin() + first, samples.begin() + last);
+    REQUIRE(summary.count == last - first);
+    REQUIRE(summary.min == *minmax.first);
+    REQUIRE(summary.max == *minmax.second);
+    REQUIRE(summary.sum == accumulate(samples.begin() + first, samples.begin() + last, typename peak_summary<T>::sum_type(0)));
+}
+
+TEST_CASE("[peak_pyramid] VALID peak_pyramid(...)") {
+
+    vector<short> samples(100003);
+    unsigned seed = 99;
+    for(auto& s : samples) {
+        seed = seed * 1103515245u + 12345u;
+        s = short(seed >> 16);
+    }
+
+    SUBCASE("[peak_pyramid] levels up to a single root") {
+        const peak_pyramid<short> pyramid(samples.data(), samples.size(), 64, 4);
+        CHECK(pyramid.level(0).size() == (samples.size() + 63) / 64);
+        CHECK(pyramid.level(pyramid.levels_size() - 1).size() == 1);
+        check_summary(samples, pyramid.level(pyramid.levels_size() - 1)[0], 0, samples.size());
+    }
+
+    SUBCASE("[peak_pyramid] summarize() is exact for any run") {
+        for(size_t block_size : {1, 16, 64}) {
+            for(size_t decimation : {2, 3, 8}) {
+                const peak_pyramid<short> pyramid(samples.data(), samples.size(), block_size, decimation);
+                const pair<size_t, size_t> runs[] = {{0, 1}, {0, samples.size()}, {5, 6}, {63, 65}, {64, 128}, {100, 99000}, {777, 60000}, {99999, 100003}};
+                for(auto run : runs) {
+                    check_summary(samples, pyramid.summarize(run.first, run.second), run.first, run.second);
+                }
+            }
+        }
+    }
+
+    SUBCASE("[peak_pyramid] columns() match for_n_ranges_linear() at any width") {
+        const peak_pyramid<short> pyramid(samples.data(), samples.size());
+        for(size_t width : {1, 7, 640, 1920, 50000}) {
+            vector<peak_summary<short>> columns;
+            pyramid.columns(back_inserter(columns), width, 3);
+            REQUIRE(columns.size() == width);
+            size_t i = 0;
+            for_n_ranges_linear(samples.begin(), samples.end(), width, 3, [&](size_t, auto b, auto e) {
+                check_summary(samples, columns[i++], b - samples.begin(), e - samples.begin());
+            });
+        }
+    }
+
+    SUBCASE("[peak_pyramid] update() and append() match a rebuilt pyramid") {
+        vector<short> recording(samples.begin(), samples.begin() + 1000);
+        peak_pyramid<short> pyramid(recording.data(), recording.size(), 16, 3);
+        for(size_t block : {1, 15, 16, 1000, 30000, 4000}) {
+            recording.insert(recording.end(), samples.begin() + recording.size(), samples.begin() + recording.size() + block);
+            pyramid.append(recording.data(), recording.size());
+        }
+        for(size_t i = 500; i < 9000; i += 7) {
+            recording[i] = short(recording[i] / 3);
+        }
+        pyramid.update(500, 9000);
+
+        const peak_pyramid<short> rebuilt(recording.data(), recording.size(), 16, 3);
+        REQUIRE(pyramid.levels_size() == rebuilt.levels_size());
+        for(size_t k = 0; k < rebuilt.levels_size(); ++k) {
+            REQUIRE(pyramid.level(k).size() == rebuilt.level(k).size());
+            for(size_t i = 0; i < rebuilt.level(k).size(); ++i) {
+                check_summary(recording, pyramid.level(k)[i], i * rebuilt.node_size(k), min(recording.size(), (i + 1) * rebuilt.node_size(k)));
+            }
+        }
+    }
+}
+
+TEST_CASE("[peak_columns] VALID peak_columns(...)") {
+
+    vector<short> samples(50021);
+    unsigned seed = 5;
+    for(auto& s : samples) {
+        seed = seed * 1103515245u + 12345u;
+        s = short(seed >> 16);
+    }
+    const n_ranges_linear_desc desc(samples.size(), 640, 2);
+
+    auto check_columns = [&](vector<short> const& recording, peak_columns<short> const& view) {
+        for(size_t i = 0; i < desc.ranges_size; ++i) {
+            const size_t b = desc.range_begin(i);
+            const size_t e = min(recording.size(), desc.range_end(i));
+            if(b < e) {
+                check_summary(recording, view.columns()[i], b, e);
+            }
+            else {
+                REQUIRE(view.columns()[i].count == 0);
+            }
+        }
+    };
+
+    SUBCASE("[peak_columns] appends refresh only the columns they reach") {
+        vector<short> recording(samples.begin(), samples.begin() + 3000);
+        peak_pyramid<short> pyramid(recording.data(), recording.size());
+        peak_columns<short> view(pyramid, desc);
+        check_columns(recording, view);
+        while(recording.size() < samples.size()) {
+            const size_t old_size = recording.size();
+            recording.insert(recording.end(), samples.begin() + old_size, samples.begin() + min(samples.size(), old_size + 4410));
+            pyramid.append(recording.data(), recording.size());
+            const auto dirty = view.refresh(old_size, recording.size());
+            CHECK(dirty.first == desc.range_of_element(old_size));
+            CHECK(dirty.second == desc.range_of_element(recording.size() - 1) + 1);
+            check_columns(recording, view);
+        }
+    }
+
+    SUBCASE("[peak_columns] edits refresh the columns they overlap") {
+        vector<short> recording = samples;
+        peak_pyramid<short> pyramid(recording.data(), recording.size());
+        peak_columns<short> view(pyramid, desc);
+        fill(recording.begin() + 20000, recording.begin() + 20100, short(0));
+        pyramid.update(20000, 20100);
+        const auto dirty = view.refresh(20000, 20100);
+        CHECK(dirty.second - dirty.first <= 3);
+        check_columns(recording, view);
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // peak_pyramid_h
@@ -0,0 +1,235 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef range_minmax_index_h
+#define range_minmax_index_h
+
+#include "n_ranges_linear.h"
+#include "range_stats.h"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** An index over a sample buffer answering exact min, max, and sum queries over any [first, last) in constant time.
+
+    The samples are divided into blocks of 'block_size'. A sparse table holds the min and max of every run of '2^k' consecutive blocks starting at every block, so the extremes of any run of whole blocks are those of two overlapping table entries, and a prefix sum of block sums gives the sum of any run of whole blocks. The partial blocks at each end of a query are scanned with the SIMD kernel of range_stats(), so a query reads a few table entries and at most '2 * block_size' samples, however long the run is.
+
+        const range_minmax_index<short> index(samples.data(), samples.size());
+        transform_n_ranges_linear(index, back_inserter(columns), width, 0,
+            [](peak_summary<short> const& column) { return column; });
+
+    The table takes 'log2(samples_size/block_size)' entries of two samples per block, for example 1/6 of the size of the samples themselves at the default block size of 256 and a million blocks. The index refers to the samples rather than copying them, so the buffer must outlive it and must not move. @see peak_pyramid for a smaller structure with logarithmic queries.
+*/
+template<typename T>
+class range_minmax_index {
+public:
+    typedef typename peak_summary<T>::sum_type sum_type;
+
+    /** @param samples The samples to index.
+        @param samples_size The number of samples.
+        @param block_size The number of samples per block, the most scanned at each end of a query.
+
+        PRECONDITIONS:
+            samples_size > 0
+            block_size > 0
+    */
+    range_minmax_index(T const* samples, const size_t samples_size, const size_t block_size = 256)
+    : samples_(samples)
+    , samples_size_(samples_size)
+    , block_size_(block_size) {
+        assert_true(samples_size > 0 and block_size > 0);
+
+        const size_t blocks_size = samples_size / block_size;
+        mins_.emplace_back(blocks_size);
+        maxs_.emplace_back(blocks_size);
+        prefix_sums_.resize(blocks_size + 1, 0);
+        for(size_t i = 0; i < blocks_size; ++i) {
+            const auto block = peak_summary<T>::of(samples + i * block_size, samples + (i + 1) * block_size);
+            mins_[0][i] = block.min;
+            maxs_[0][i] = block.max;
+            prefix_sums_[i + 1] = prefix_sums_[i] + block.sum;
+        }
+        for(size_t span = 2; span <= blocks_size; span *= 2) {
+            auto const& mins = mins_.back();
+            auto const& maxs = maxs_.back();
+            std::vector<T> next_mins(blocks_size - span + 1), next_maxs(blocks_size - span + 1);
+            for(size_t i = 0; i < next_mins.size(); ++i) {
+                next_mins[i] = std::min(mins[i], mins[i + span / 2]);
+                next_maxs[i] = std::max(maxs[i], maxs[i + span / 2]);
+            }
+            mins_.push_back(std::move(next_mins));
+            maxs_.push_back(std::move(next_maxs));
+        }
+    }
+
+    /// The number of samples indexed.
+    size_t size() const {
+        return samples_size_;
+    }
+
+    /// The exact min, max, sum, and count of samples [first, last).
+    peak_summary<T> query(const size_t first, const size_t last) const {
+        assert_true(first < last and last <= samples_size_);
+
+        const size_t b = (first + block_size_ - 1) / block_size_;
+        const size_t e = last / block_size_;
+        if(b >= e) {
+            return peak_summary<T>::of(samples_ + first, samples_ + last);
+        }
+
+        size_t level = 0;
+        while((size_t(2) << level) <= e - b) {
+            ++level;
+        }
+        const size_t second = e - (size_t(1) << level);
+
+        peak_summary<T> summary;
+        summary.min = std::min(mins_[level][b], mins_[level][second]);
+        summary.max = std::max(maxs_[level][b], maxs_[level][second]);
+        summary.sum = prefix_sums_[e] - prefix_sums_[b];
+        summary.count = (e - b) * block_size_;
+        if(first < b * block_size_) {
+            summary.merge(peak_summary<T>::of(samples_ + first, samples_ + b * block_size_));
+        }
+        if(e * block_size_ < last) {
+            summary.merge(peak_summary<T>::of(samples_ + e * block_size_, samples_ + last));
+        }
+        return summary;
+    }
+
+private:
+    T const*                        samples_;
+    size_t                          samples_size_;
+    size_t                          block_size_;
+    std::vector<std::vector<T>>     mins_;          // mins_[k][i] is the min of blocks [i, i + 2^k).
+    std::vector<std::vector<T>>     maxs_;          // maxs_[k][i] is the max of blocks [i, i + 2^k).
+    std::vector<sum_type>           prefix_sums_;   // prefix_sums_[i] is the sum of blocks [0, i).
+};
+
+
+/** Transforms the samples behind an index in chunks of 'n' 'equalest-possible' ranges, without reading the samples in between.
+
+    Each range is the same as for_n_ranges_linear() would give over the indexed samples, but 'summary_func' receives the exact peak_summary of the range from range_minmax_index::query() instead of a pair of iterators. Each range costs a few table reads and at most two partial blocks of samples.
+
+    @param index The index over the samples.
+    @param output_iter The write iterator for the results.
+    @param ranges_size The number of ranges to divide the samples into.
+    @param distribution_offset When calculating the distribution this offset is applied. @see for_n_ranges_linear() for more information.
+    @param summary_func Transform func that takes a peak_summary<T> const& and returns an arbitrary value insertable into output_iter.
+
+    PRECONDITIONS:
+    POSTCONDITIONS:
+        @see: for_n_ranges_linear()
+*/
+template<typename T, typename OutputIter, typename SummaryFunc>
+void transform_n_ranges_linear (
+    range_minmax_index<T> const&    index,
+    OutputIter                      output_iter,
+    const size_t                    ranges_size,
+    const size_t                    distribution_offset,
+    SummaryFunc                     summary_func
+) {
+    const n_ranges_linear_desc desc(index.size(), ranges_size, distribution_offset);
+    n_ranges_linear_stepper step(desc);
+    while(step.range_index < ranges_size) {
+        const size_t b = step.range_begin;
+        *output_iter++ = summary_func(index.query(b, b + step.next_size()));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[range_minmax_index] VALID range_minmax_index(...)") {
+
+    vector<float> samples(70001);
+    unsigned seed = 7;
+    for(auto& s : samples) {
+        seed = seed * 1103515245u + 12345u;
+        s = float(int(seed >> 16) - 32768) / 100.0f;
+    }
+
+    auto check = [&](peak_summary<float> const& summary, size_t first, size_t last) {
+        const auto minmax = minmax_element(samples.begin() + first, samples.begin() + last);
+        REQUIRE(summary.count == last - first);
+        REQUIRE(summary.min == *minmax.first);
+        REQUIRE(summary.max == *minmax.second);
+        REQUIRE(summary.sum == doctest::Approx(accumulate(samples.begin() + first, samples.begin() + last, 0.0)));
+    };
+
+    SUBCASE("[range_minmax_index] query() is exact for any run") {
+        for(size_t block_size : {1, 64, 256}) {
+            const range_minmax_index<float> index(samples.data(), samples.size(), block_size);
+            const pair<size_t, size_t> runs[] = {{0, 1}, {0, samples.size()}, {255, 257}, {256, 512}, {100, 69000}, {1000, 1513}, {69990, 70001}};
+            for(auto run : runs) {
+                check(index.query(run.first, run.second), run.first, run.second);
+            }
+            for(size_t first = 0; first < samples.size(); first += 997) {
+                check(index.query(first, min(samples.size(), first + 3001)), first, min(samples.size(), first + 3001));
+            }
+        }
+    }
+
+    SUBCASE("[range_minmax_index] transform_n_ranges_linear() over the index") {
+        const range_minmax_index<float> index(samples.data(), samples.size());
+        vector<peak_summary<float>> columns;
+        transform_n_ranges_linear(index, back_inserter(columns), 1920, 1, [](peak_summary<float> const& column) {
+            return column;
+        });
+        REQUIRE(columns.size() == 1920);
+        size_t i = 0;
+        for_n_ranges_linear(samples.begin(), samples.end(), 1920, 1, [&](size_t, auto b, auto e) {
+            check(columns[i++], b - samples.begin(), e - samples.begin());
+        });
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // range_minmax_index_h
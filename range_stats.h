@@ -0,0 +1,668 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef range_stats_h
+#define range_stats_h
+
+#include "n_ranges_linear.h"
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#ifndef DOCTEST_CONFIG_DISABLE
+#include <list>
+#include <deque>
+#endif
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// Sums are kept in 64 bits, and within a block in the narrowest lanes that cannot overflow.
+template<typename T, typename = void>
+struct stats_traits {
+    typedef double sum_type;
+    typedef double lane_sum_type;
+};
+
+template<typename T>
+struct stats_traits<T, std::enable_if_t<std::is_integral<T>::value>> {
+    typedef std::conditional_t<std::is_signed<T>::value, std::int64_t, std::uint64_t> sum_type;
+    typedef std::conditional_t<(sizeof(T) > 2), sum_type,
+        std::conditional_t<std::is_signed<T>::value, std::int32_t, std::uint32_t>> lane_sum_type;
+};
+
+// Elements per block: small enough that a block's lanes cannot overflow and that a block is still in L1 when it is searched for an extreme.
+const size_t stats_block_size = 1024;
+
+/* The min, max, and sum of one block, kept in one register's worth of independent lanes. Each lane only depends on itself, so the loop body compiles to vertical SIMD min, max, and add instructions (with widening for the sums), and the lanes are folded together once per block. */
+template<typename T>
+void block_stats(T const* p, const size_t n, T& lo, T& hi, typename stats_traits<T>::sum_type& sum) {
+    typedef typename stats_traits<T>::lane_sum_type lane_sum_type;
+    const size_t lanes = 32 / sizeof(T);
+
+    T l[lanes], h[lanes];
+    lane_sum_type s[lanes];
+    for(size_t j = 0; j < lanes; ++j) {
+        l[j] = h[j] = p[0];
+        s[j] = 0;
+    }
+
+    size_t k = 0;
+    for(; k + lanes <= n; k += lanes) {
+        for(size_t j = 0; j < lanes; ++j) {
+            const T v = p[k + j];
+            l[j] = v < l[j] ? v : l[j];
+            h[j] = h[j] < v ? v : h[j];
+            s[j] += v;
+        }
+    }
+    for(; k < n; ++k) {
+        const T v = p[k];
+        l[0] = v < l[0] ? v : l[0];
+        h[0] = h[0] < v ? v : h[0];
+        s[0] += v;
+    }
+
+    lo = l[0];
+    hi = h[0];
+    sum = 0;
+    for(size_t j = 0; j < lanes; ++j) {
+        lo = l[j] < lo ? l[j] : lo;
+        hi = hi < h[j] ? h[j] : hi;
+        sum += s[j];
+    }
+}
+
+// The offset of the first 'x' in [p, p + n), which must hold an 'x', comparing a register's worth of elements at a time.
+template<typename T>
+size_t find_present(T const* p, const size_t n, const T x) {
+    const size_t lanes = 32 / sizeof(T);
+    size_t k = 0;
+    for(; k + lanes <= n; k += lanes) {
+        int hit = 0;
+        for(size_t j = 0; j < lanes; ++j) {
+            hit |= p[k + j] == x ? 1 : 0;
+        }
+        if(hit) {
+            break;
+        }
+    }
+    for(; p[k] != x; ++k) {}
+    return k;
+}
+
+#if defined(__SSE2__)
+/* Compilers will not vectorize the floating point min and max selects of the generic kernel without relaxed math flags, so floats and doubles use SSE2 directly, with two registers of each accumulator to hide the latency of the adds. '_mm_min_ps(v, l)' is exactly 'v < l ? v : l', so the results are identical to the generic kernel. */
+inline void block_stats(float const* p, const size_t n, float& lo, float& hi, double& sum) {
+    __m128 l0 = _mm_set1_ps(p[0]), l1 = l0, h0 = l0, h1 = l0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+
+    size_t k = 0;
+    for(; k + 8 <= n; k += 8) {
+        const __m128 v0 = _mm_loadu_ps(p + k);
+        const __m128 v1 = _mm_loadu_ps(p + k + 4);
+        l0 = _mm_min_ps(v0, l0);
+        l1 = _mm_min_ps(v1, l1);
+        h0 = _mm_max_ps(v0, h0);
+        h1 = _mm_max_ps(v1, h1);
+        s0 = _mm_add_pd(s0, _mm_cvtps_pd(v0));
+        s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(v0, v0)));
+        s2 = _mm_add_pd(s2, _mm_cvtps_pd(v1));
+        s3 = _mm_add_pd(s3, _mm_cvtps_pd(_mm_movehl_ps(v1, v1)));
+    }
+
+    float l[4], h[4];
+    double t[2];
+    _mm_storeu_ps(l, _mm_min_ps(l0, l1));
+    _mm_storeu_ps(h, _mm_max_ps(h0, h1));
+    _mm_storeu_pd(t, _mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+    lo = std::min({l[0], l[1], l[2], l[3]});
+    hi = std::max({h[0], h[1], h[2], h[3]});
+    sum = t[0] + t[1];
+    for(; k < n; ++k) {
+        lo = p[k] < lo ? p[k] : lo;
+        hi = hi < p[k] ? p[k] : hi;
+        sum += p[k];
+    }
+}
+
+inline void block_stats(double const* p, const size_t n, double& lo, double& hi, double& sum) {
+    __m128d l0 = _mm_set1_pd(p[0]), l1 = l0, h0 = l0, h1 = l0;
+    __m128d s0 = _mm_setzero_pd(), s1 = s0;
+
+    size_t k = 0;
+    for(; k + 4 <= n; k += 4) {
+        const __m128d v0 = _mm_loadu_pd(p + k);
+        const __m128d v1 = _mm_loadu_pd(p + k + 2);
+        l0 = _mm_min_pd(v0, l0);
+        l1 = _mm_min_pd(v1, l1);
+        h0 = _mm_max_pd(v0, h0);
+        h1 = _mm_max_pd(v1, h1);
+        s0 = _mm_add_pd(s0, v0);
+        s1 = _mm_add_pd(s1, v1);
+    }
+
+    double l[2], h[2], t[2];
+    _mm_storeu_pd(l, _mm_min_pd(l0, l1));
+    _mm_storeu_pd(h, _mm_max_pd(h0, h1));
+    _mm_storeu_pd(t, _mm_add_pd(s0, s1));
+    lo = std::min(l[0], l[1]);
+    hi = std::max(h[0], h[1]);
+    sum = t[0] + t[1];
+    for(; k < n; ++k) {
+        lo = p[k] < lo ? p[k] : lo;
+        hi = hi < p[k] ? p[k] : hi;
+        sum += p[k];
+    }
+}
+#endif
+
+
+// Maps 8 and 16 bit samples to unsigned keys of the same order, by flipping the sign bit of signed types.
+template<typename T>
+struct median_key {
+    typedef std::make_unsigned_t<T> key_type;
+    static constexpr key_type sign = std::is_signed<T>::value ? key_type(key_type(1) << (sizeof(T) * 8 - 1)) : key_type(0);
+
+    static key_type of(const T x) {
+        return key_type(key_type(x) ^ sign);
+    }
+
+    static T value(const size_t key) {
+        return T(key_type(key ^ sign));
+    }
+};
+
+// Counts 'bin(x)' of the 'size' elements from 'begin' into 'counts', through 4 interleaved histograms so that runs of equal samples do not wait on the same counter.
+template<typename ForwardIter, typename BinFunc>
+void histogram_256(ForwardIter begin, const size_t size, size_t (&counts)[256], BinFunc bin) {
+    size_t lanes[4][256] = {};
+    size_t i = 0;
+    for(; i + 4 <= size; i += 4) {
+        ++lanes[0][bin(*begin)]; ++begin;
+        ++lanes[1][bin(*begin)]; ++begin;
+        ++lanes[2][bin(*begin)]; ++begin;
+        ++lanes[3][bin(*begin)]; ++begin;
+    }
+    for(; i < size; ++i, ++begin) {
+        ++lanes[0][bin(*begin)];
+    }
+    for(size_t b = 0; b < 256; ++b) {
+        counts[b] = lanes[0][b] + lanes[1][b] + lanes[2][b] + lanes[3][b];
+    }
+}
+
+// The bin of a histogram holding the element of rank 'rank', reducing 'rank' to the rank within that bin.
+inline size_t select_bin(size_t const (&counts)[256], size_t& rank) {
+    size_t bin = 0;
+    for(; rank >= counts[bin]; ++bin) {
+        rank -= counts[bin];
+    }
+    return bin;
+}
+
+// The elements of ranks 'low_rank' and 'high_rank' of 8 bit samples, from one 256 bin histogram.
+template<typename ForwardIter, typename T>
+std::pair<T, T> select_ranks(ForwardIter begin, const size_t size, size_t low_rank, size_t high_rank, std::integral_constant<size_t, 1>) {
+    typedef median_key<T> key;
+    size_t counts[256];
+    histogram_256(begin, size, counts, [](const T x) { return key::of(x); });
+    return std::make_pair(key::value(select_bin(counts, low_rank)), key::value(select_bin(counts, high_rank)));
+}
+
+// The elements of ranks 'low_rank' and 'high_rank' of 16 bit samples, from a 256 bin histogram of the high bytes and then one of the low bytes within the bins holding the ranks.
+template<typename ForwardIter, typename T>
+std::pair<T, T> select_ranks(ForwardIter begin, const size_t size, size_t low_rank, size_t high_rank, std::integral_constant<size_t, 2>) {
+    typedef median_key<T> key;
+    size_t counts[256];
+    histogram_256(begin, size, counts, [](const T x) { return key::of(x) >> 8; });
+    const size_t low_bin = select_bin(counts, low_rank);
+    const size_t high_bin = select_bin(counts, high_rank);
+
+    size_t low_bytes[2][256] = {};
+    for(size_t i = 0; i < size; ++i, ++begin) {
+        const size_t k = key::of(*begin);
+        if(k >> 8 == low_bin) {
+            ++low_bytes[0][k & 0xff];
+        }
+        else if(k >> 8 == high_bin) {
+            ++low_bytes[1][k & 0xff];
+        }
+    }
+    const size_t low_key = low_bin << 8 | select_bin(low_bytes[0], low_rank);
+    const size_t high_key = high_bin << 8 | select_bin(low_bytes[high_bin == low_bin ? 0 : 1], high_rank);
+    return std::make_pair(key::value(low_key), key::value(high_key));
+}
+
+} // END namespace detail
+
+
+/// The summary of a range computed by range_stats().
+template<typename T>
+struct range_statistics {
+    typedef typename detail::stats_traits<T>::sum_type sum_type;
+
+    /// The arithmetic mean of the range.
+    double mean() const {
+        return double(sum) / double(count);
+    }
+
+    T           min;        // The smallest element.
+    T           max;        // The largest element.
+    size_t      min_index;  // The offset from the range begin of the first smallest element.
+    size_t      max_index;  // The offset from the range begin of the first largest element.
+    sum_type    sum;        // The sum of all elements, in 64 bit integers or doubles.
+    size_t      count;      // The number of elements.
+};
+
+
+/** Computes the min, max, their positions, the sum, and the count of a contiguous range in one pass.
+
+    Replaces separate calls to std::minmax_element() and std::accumulate() (and the reads of memory they each cost) with a single read of the range, and is designed to be used directly as the range func of transform_n_ranges_linear():
+
+        vector<range_statistics<short>> columns;
+        transform_n_ranges_linear(samples.begin(), samples.end(), back_inserter(columns), width, 0,
+            [](auto b, auto e) { return range_stats(b, e); });
+
+    The range is read in blocks of a few thousand bytes, keeping min, max, and sum in independent SIMD lanes (written so that compilers vectorize them for integers, and with SSE2 for floats and doubles). Only the value of each extreme is tracked while streaming, along with the block it was found in, and the position is recovered by searching that single block at the end. Sums of 8 and 16 bit elements are widened to 32 bit lanes within a block and to 64 bits between blocks, so they cannot overflow for any practical range.
+
+    @param begin The beginning of a contiguous range of 8, 16, 32, or 64 bit integers, floats, or doubles (eg. a pointer or a std::vector iterator).
+    @param end The end of the range.
+    @return The statistics of [begin, end).
+
+    PRECONDITIONS:
+        begin < end
+        [begin, end) is contiguous in memory
+        floating point elements are not NaN
+*/
+template<typename T>
+range_statistics<T> range_stats(T const* begin, T const* end) {
+    static_assert(std::is_arithmetic<T>::value, "range_stats() needs arithmetic elements.");
+    assert_true(begin < end);
+
+    const size_t size = end - begin;
+    range_statistics<T> stats;
+    stats.min = stats.max = *begin;
+    stats.sum = 0;
+    stats.count = size;
+
+    size_t min_block = 0, max_block = 0;
+    for(size_t b = 0; b < size; b += detail::stats_block_size) {
+        T lo, hi;
+        typename range_statistics<T>::sum_type sum;
+        detail::block_stats(begin + b, std::min(detail::stats_block_size, size - b), lo, hi, sum);
+        stats.sum += sum;
+        if(lo < stats.min) {
+            stats.min = lo;
+            min_block = b;
+        }
+        if(stats.max < hi) {
+            stats.max = hi;
+            max_block = b;
+        }
+    }
+
+    stats.min_index = min_block + detail::find_present(begin + min_block, size - min_block, stats.min);
+    stats.max_index = max_block + detail::find_present(begin + max_block, size - max_block, stats.max);
+    return stats;
+}
+
+
+namespace detail {
+
+// True for the iterators known to address contiguous memory: pointers, and std::vector and std::array iterators (but not std::vector<bool>'s).
+template<typename Iter, typename T = std::remove_cv_t<typename std::iterator_traits<Iter>::value_type>>
+using is_contiguous_iterator = std::integral_constant<bool, not std::is_same<T, bool>::value and (
+    std::is_pointer<Iter>::value
+    or std::is_same<Iter, typename std::vector<T>::iterator>::value
+    or std::is_same<Iter, typename std::vector<T>::const_iterator>::value
+    or std::is_same<Iter, typename std::array<T, 1>::iterator>::value
+    or std::is_same<Iter, typename std::array<T, 1>::const_iterator>::value)>;
+
+template<typename ContiguousIter>
+auto range_stats(ContiguousIter begin, ContiguousIter end, std::true_type) {
+    typedef std::remove_reference_t<decltype(*begin)> element_type;
+    element_type* first = &*begin;
+    return ec::range_stats<std::remove_cv_t<element_type>>(first, first + std::distance(begin, end));
+}
+
+// One element at a time, for iterators that are not known to be contiguous (eg. a summary_rope's).
+template<typename ForwardIter>
+auto range_stats(ForwardIter begin, ForwardIter end, std::false_type) {
+    typedef std::remove_cv_t<typename std::iterator_traits<ForwardIter>::value_type> element_type;
+    range_statistics<element_type> stats;
+    stats.min = stats.max = *begin;
+    stats.min_index = stats.max_index = 0;
+    stats.sum = 0;
+    for(stats.count = 0; begin != end; ++begin, ++stats.count) {
+        const element_type x = *begin;
+        if(x < stats.min) {
+            stats.min = x;
+            stats.min_index = stats.count;
+        }
+        if(stats.max < x) {
+            stats.max = x;
+            stats.max_index = stats.count;
+        }
+        stats.sum += x;
+    }
+    return stats;
+}
+
+} // END namespace detail
+
+
+/** Computes range_stats() of a range given by iterators, @see range_stats(T const*, T const*).
+
+    Pointers and std::vector and std::array iterators use the SIMD kernel on the underlying memory. Any other forward iterator (eg. from std::deque or summary_rope) is read one element at a time, with the same results.
+
+    PRECONDITIONS:
+        begin != end
+*/
+template<typename ForwardIter>
+auto range_stats(ForwardIter begin, ForwardIter end) {
+    assert_true(begin != end);
+    return detail::range_stats(begin, end, detail::is_contiguous_iterator<ForwardIter>());
+}
+
+
+/// The min, max, sum, and count of a run of samples, which can be merged with the summary of another run.
+template<typename T>
+struct peak_summary {
+    typedef typename range_statistics<T>::sum_type sum_type;
+
+    /// The summary of [first, last), which must not be empty.
+    static peak_summary of(T const* first, T const* last) {
+        assert_true(first < last);
+        peak_summary summary;
+        summary.count = last - first;
+        for(T const* block = first; block < last; block += detail::stats_block_size) {
+            T lo, hi;
+            sum_type sum;
+            detail::block_stats(block, std::min<size_t>(detail::stats_block_size, last - block), lo, hi, sum);
+            summary.min = block == first or lo < summary.min ? lo : summary.min;
+            summary.max = block == first or summary.max < hi ? hi : summary.max;
+            summary.sum += sum;
+        }
+        return summary;
+    }
+
+    /// An empty summary, which leaves any summary merged into it unchanged.
+    peak_summary()
+    : min(), max(), sum(0), count(0) {
+    }
+
+    /// The summary of the elements described by 'stats'.
+    explicit peak_summary(range_statistics<T> const& stats)
+    : min(stats.min), max(stats.max), sum(stats.sum), count(stats.count) {
+    }
+
+    /// Adds the elements summarized by 'other'.
+    void merge(peak_summary const& other) {
+        if(other.count == 0) {
+            return;
+        }
+        min = count == 0 or other.min < min ? other.min : min;
+        max = count == 0 or max < other.max ? other.max : max;
+        sum += other.sum;
+        count += other.count;
+    }
+
+    /// The arithmetic mean of the elements.
+    double mean() const {
+        return double(sum) / double(count);
+    }
+
+    T           min;
+    T           max;
+    sum_type    sum;
+    size_t      count;
+};
+
+
+/** Computes the exact median of a range of 8 or 16 bit integer samples with histograms, without copying or reordering the range.
+
+    A drop in replacement for copying each range and calling std::nth_element(), designed to be used directly as the range func of transform_n_ranges_linear():
+
+        transform_n_ranges_linear(samples.begin(), samples.end(), back_inserter(medians), width, 0,
+            [](auto b, auto e) { return range_median_histogram(b, e); });
+
+    8 bit samples are counted into 256 bins in one pass. 16 bit samples are counted by their high byte into 256 bins, and a second pass counts the low bytes of only the samples in the bins holding the middle ranks, so neither needs more than a few kilobytes of stack. Counts are spread over 4 interleaved histograms, so that runs of equal samples (common in quiet audio) do not stall on one counter. The cost is O(size + 256) whatever the order of the samples.
+
+    @param begin The beginning of a range of 8 or 16 bit integers, read once for 8 bit and twice for 16 bit samples.
+    @param end The end of the range.
+    @return The middle sample for an odd number of samples, or the mean of the two middle samples for an even number.
+
+    PRECONDITIONS:
+        begin != end
+*/
+template<typename ForwardIter>
+double range_median_histogram(ForwardIter begin, ForwardIter end) {
+    typedef std::remove_cv_t<typename std::iterator_traits<ForwardIter>::value_type> element_type;
+    static_assert(std::is_integral<element_type>::value and (sizeof(element_type) == 1 or sizeof(element_type) == 2),
+        "range_median_histogram() needs 8 or 16 bit integer elements.");
+    assert_true(begin != end);
+
+    const size_t size = std::distance(begin, end);
+    const auto middle = detail::select_ranks<ForwardIter, element_type>(begin, size, (size - 1) / 2, size / 2,
+        std::integral_constant<size_t, sizeof(element_type)>());
+    return (double(middle.first) + double(middle.second)) / 2.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+template<typename T>
+void check_range_stats(vector<T> const& in) {
+    for(size_t size : {size_t(1), size_t(2), size_t(31), size_t(1024), size_t(1025), in.size()}) {
+        const auto stats = range_stats(in.begin(), in.begin() + size);
+        const auto lo = min_element(in.begin(), in.begin() + size);
+        const auto hi = max_element(in.begin(), in.begin() + size);
+        REQUIRE(stats.count == size);
+        REQUIRE(stats.min == *lo);
+        REQUIRE(stats.max == *hi);
+        REQUIRE(stats.min_index == size_t(lo - in.begin()));
+        REQUIRE(stats.max_index == size_t(hi - in.begin()));
+        typename range_statistics<T>::sum_type sum = 0;
+        for(size_t k = 0; k < size; ++k) {
+            sum += in[k];
+        }
+        if(is_floating_point<T>::value) {
+            REQUIRE(double(stats.sum) == doctest::Approx(double(sum)));
+        }
+        else {
+            REQUIRE(stats.sum == sum);
+        }
+    }
+}
+
+TEST_CASE("[range_stats] VALID range_stats(...)") {
+
+    const size_t size = 10007;
+    unsigned seed = 12345;
+    auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 8; };
+
+    vector<int8_t> s8(size);
+    vector<uint8_t> u8(size);
+    vector<int16_t> s16(size);
+    vector<uint16_t> u16(size);
+    vector<int32_t> s32(size);
+    vector<float> f32(size);
+    vector<double> f64(size);
+    for(size_t k = 0; k < size; ++k) {
+        const unsigned r = next();
+        s8[k] = int8_t(r);
+        u8[k] = uint8_t(r >> 3);
+        s16[k] = int16_t(r);
+        u16[k] = uint16_t(r >> 2);
+        s32[k] = int32_t(r * 2654435761u);
+        f32[k] = float(int(r % 20001) - 10000) / 7.0f;
+        f64[k] = double(int(r % 200001) - 100000) / 3.0;
+    }
+
+    SUBCASE("[range_stats] matches min_element(), max_element(), and a serial sum") {
+        check_range_stats(s8);
+        check_range_stats(u8);
+        check_range_stats(s16);
+        check_range_stats(u16);
+        check_range_stats(s32);
+        check_range_stats(f32);
+        check_range_stats(f64);
+    }
+
+    SUBCASE("[range_stats] extremes report their first position") {
+        vector<uint8_t> flat(5000, 7);
+        flat[3000] = 9;
+        flat[4000] = 9;
+        const auto stats = range_stats(flat.data(), flat.data() + flat.size());
+        CHECK(stats.min_index == 0);
+        CHECK(stats.max_index == 3000);
+        CHECK(stats.mean() == doctest::Approx((7.0 * 4998 + 18.0) / 5000.0));
+    }
+
+    SUBCASE("[range_stats] as the range func of transform_n_ranges_linear()") {
+        vector<range_statistics<int16_t>> columns;
+        transform_n_ranges_linear(s16.begin(), s16.end(), back_inserter(columns), 100, 0,
+            [](auto b, auto e) { return range_stats(b, e); });
+        REQUIRE(columns.size() == 100);
+        size_t count = 0;
+        for(auto const& column : columns) {
+            count += column.count;
+        }
+        CHECK(count == size);
+    }
+}
+
+template<typename T>
+void check_range_median(vector<T> const& in) {
+    for(size_t size : {size_t(1), size_t(2), size_t(3), size_t(4), size_t(255), size_t(1000), in.size()}) {
+        const double median = range_median_histogram(in.begin(), in.begin() + size);
+        vector<T> sorted(in.begin(), in.begin() + size);
+        sort(sorted.begin(), sorted.end());
+        REQUIRE(median == (double(sorted[(size - 1) / 2]) + double(sorted[size / 2])) / 2.0);
+    }
+}
+
+TEST_CASE("[range_stats] VALID range_stats(...) over iterators that are not contiguous") {
+
+    const vector<short> in = {5, -3, 7, 7, -3, 2, 0, 7};
+    const deque<short> chunked(in.begin(), in.end());
+    const list<short> linked(in.begin(), in.end());
+    const auto expected = range_stats(in.begin(), in.end());
+    for(auto stats : {range_stats(chunked.begin(), chunked.end()), range_stats(linked.begin(), linked.end())}) {
+        CHECK(stats.min == expected.min);
+        CHECK(stats.max == expected.max);
+        CHECK(stats.min_index == 1);
+        CHECK(stats.max_index == 2);
+        CHECK(stats.min_index == expected.min_index);
+        CHECK(stats.max_index == expected.max_index);
+        CHECK(stats.sum == expected.sum);
+        CHECK(stats.count == expected.count);
+    }
+}
+
+TEST_CASE("[range_median_histogram] VALID range_median_histogram(...)") {
+
+    const size_t size = 4099;
+    unsigned seed = 777;
+    auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 8; };
+
+    SUBCASE("[range_median_histogram] matches sorting for 8 and 16 bit samples") {
+        vector<unsigned char> u8(size);
+        vector<signed char> s8(size);
+        vector<uint16_t> u16(size);
+        vector<short> s16(size);
+        for(size_t k = 0; k < size; ++k) {
+            u8[k] = (unsigned char)next();
+            s8[k] = (signed char)next();
+            u16[k] = uint16_t(next());
+            s16[k] = short(next());
+        }
+        check_range_median(u8);
+        check_range_median(s8);
+        check_range_median(u16);
+        check_range_median(s16);
+
+        // Narrow ranges put both middle samples in the same or neighbouring high byte bins.
+        for(auto& s : s16) {
+            s = short(int(next() % 600) - 300);
+        }
+        check_range_median(s16);
+        check_range_median(vector<short>(size, -7));
+    }
+
+    SUBCASE("[range_median_histogram] as a range func") {
+        vector<short> in(size);
+        for(auto& s : in) {
+            s = short(next());
+        }
+        vector<double> medians;
+        transform_n_ranges_linear(in.begin(), in.end(), back_inserter(medians), 64, 0, [](auto b, auto e) {
+            return range_median_histogram(b, e);
+        });
+        size_t i = 0;
+        for_n_ranges_linear(in.begin(), in.end(), 64, 0, [&](size_t, auto b, auto e) {
+            vector<short> sorted(b, e);
+            sort(sorted.begin(), sorted.end());
+            const size_t n = sorted.size();
+            REQUIRE(medians[i++] == (double(sorted[(n - 1) / 2]) + double(sorted[n / 2])) / 2.0);
+        });
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // range_stats_h
@@ -0,0 +1,616 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef summary_rope_h
+#define summary_rope_h
+
+#include "n_ranges_linear.h"
+#include "range_stats.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+// A different seed for the node priorities of every rope (splitmix64 of a counter), so that ropes built apart stay balanced when joined.
+inline uint32_t rope_seed() {
+    static std::atomic<uint64_t> ropes(0);
+    uint64_t z = (++ropes) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return uint32_t(z ^ (z >> 31)) | 1u;
+}
+
+} // END namespace detail
+
+
+/** A sample buffer made of chunks, supporting insert, erase, cut, and paste anywhere in O(log(chunks)) plus the chunks touched.
+
+    The chunks are the nodes of a balanced tree (a treap ordered by position), and every node carries the peak_summary of its chunk and of its whole subtree. Every node has a random priority, not less than those of its children, which keeps the expected depth O(log(chunks)) whatever the order of the edits. An edit splits at most the two chunks at its ends and relinks O(log(chunks)) nodes, so nothing after the edit is moved and no summary outside the path to the edit is recomputed. A chunk left with fewer than 'chunk_size/2' samples at either end of an edit is merged with its neighbour, so repeated small edits do not break the rope into tiny chunks. A peak query merges the subtree summaries that fit in the run and scans at most the two partial chunks at its ends, like peak_pyramid::summarize().
+
+        summary_rope<short> rope(samples.begin(), samples.end());
+        auto clip = rope.extract(cut_first, cut_last);     // cut
+        rope.insert(paste_at, std::move(clip));             // paste
+        rope.columns(back_inserter(columns), width, 0);     // redraw from node summaries
+
+    The const_iterator is random access, so the rope can be passed to for_n_ranges_linear() and the other algorithms like any container. Moving an iterator within a chunk is constant time, and leaving a chunk costs O(log(chunks)). Samples are only changed through the edits, which keep the summaries current, and every edit invalidates all iterators.
+*/
+template<typename T>
+class summary_rope {
+    struct node {
+        std::vector<T>          samples;
+        peak_summary<T>         chunk;      // The summary of 'samples'.
+        peak_summary<T>         subtree;    // The summary of the subtree, whose count is its number of samples.
+        uint32_t                priority;   // Not less than the priority of either child.
+        std::unique_ptr<node>   left;
+        std::unique_ptr<node>   right;
+    };
+    typedef std::unique_ptr<node> node_ptr;
+
+public:
+    class const_iterator {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T                               value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef T const*                        pointer;
+        typedef T const&                        reference;
+
+        const_iterator()
+        : rope_(nullptr)
+        , index_(0)
+        , node_(nullptr)
+        , chunk_begin_(0) {
+        }
+
+        reference operator*() const { return node_->samples[index_ - chunk_begin_]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](const difference_type n) const { return *(*this + n); }
+
+        const_iterator& operator++() { return *this += 1; }
+        const_iterator& operator--() { return *this -= 1; }
+        const_iterator operator++(int) { const_iterator old = *this; *this += 1; return old; }
+        const_iterator operator--(int) { const_iterator old = *this; *this -= 1; return old; }
+        const_iterator& operator-=(const difference_type n) { return *this += -n; }
+        const_iterator operator+(const difference_type n) const { const_iterator i = *this; return i += n; }
+        const_iterator operator-(const difference_type n) const { const_iterator i = *this; return i += -n; }
+        friend const_iterator operator+(const difference_type n, const_iterator i) { return i += n; }
+        difference_type operator-(const_iterator const& other) const { return difference_type(index_) - difference_type(other.index_); }
+
+        const_iterator& operator+=(const difference_type n) {
+            index_ += n;
+            if(node_ == nullptr or index_ < chunk_begin_ or index_ - chunk_begin_ >= node_->samples.size()) {
+                node_ = rope_->locate(index_, chunk_begin_);
+            }
+            return *this;
+        }
+
+        bool operator==(const_iterator const& other) const { return index_ == other.index_; }
+        bool operator!=(const_iterator const& other) const { return index_ != other.index_; }
+        bool operator<(const_iterator const& other) const { return index_ < other.index_; }
+        bool operator>(const_iterator const& other) const { return index_ > other.index_; }
+        bool operator<=(const_iterator const& other) const { return index_ <= other.index_; }
+        bool operator>=(const_iterator const& other) const { return index_ >= other.index_; }
+
+    private:
+        friend class summary_rope;
+
+        const_iterator(summary_rope const* rope, const size_t index)
+        : rope_(rope)
+        , index_(index)
+        , chunk_begin_(0) {
+            node_ = rope->locate(index, chunk_begin_);
+        }
+
+        summary_rope const* rope_;
+        size_t              index_;
+        node const*         node_;          // The chunk holding 'index_', or nullptr at the end.
+        size_t              chunk_begin_;   // The index of the first sample of 'node_'.
+    };
+
+    /** @param chunk_size The most samples held by a chunk.
+
+        PRECONDITIONS:
+            chunk_size > 0
+    */
+    explicit summary_rope(const size_t chunk_size = 4096)
+    : chunk_size_(chunk_size)
+    , seed_(detail::rope_seed()) {
+        assert_true(chunk_size > 0);
+    }
+
+    /// A rope holding the samples [begin, end).
+    template<typename ForwardIter>
+    summary_rope(ForwardIter begin, ForwardIter end, const size_t chunk_size = 4096)
+    : summary_rope(chunk_size) {
+        root_ = build(begin, end);
+    }
+
+    /// The number of samples.
+    size_t size() const {
+        return size_of(root_.get());
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    /// Sample 'index', in O(log(chunks)).
+    T const& operator[](const size_t index) const {
+        size_t chunk_begin = 0;
+        node const* n = locate(index, chunk_begin);
+        assert_true(n != nullptr);
+        return n->samples[index - chunk_begin];
+    }
+
+    /** Inserts the samples [begin, end) before sample 'index'.
+
+        PRECONDITIONS:
+            index <= size()
+    */
+    template<typename ForwardIter>
+    void insert(const size_t index, ForwardIter begin, ForwardIter end) {
+        insert_nodes(index, build(begin, end));
+    }
+
+    /** Inserts all of the samples of 'other' before sample 'index', relinking its chunks without copying them.
+
+        PRECONDITIONS:
+            index <= size()
+    */
+    void insert(const size_t index, summary_rope&& other) {
+        insert_nodes(index, std::move(other.root_));
+    }
+
+    /** Removes samples [first, last).
+
+        PRECONDITIONS:
+            first <= last <= size()
+    */
+    void erase(const size_t first, const size_t last) {
+        extract(first, last);
+    }
+
+    /** Removes samples [first, last) and returns them as a rope, relinking their chunks without copying them.
+
+        PRECONDITIONS:
+            first <= last <= size()
+    */
+    summary_rope extract(const size_t first, const size_t last) {
+        assert_true(first <= last and last <= size());
+        auto head = split(std::move(root_), first);
+        auto tail = split(std::move(head.second), last - first);
+        root_ = merge(std::move(head.first), std::move(tail.second));
+        coalesce(first);
+
+        summary_rope removed(chunk_size_);
+        removed.root_ = std::move(tail.first);
+        return removed;
+    }
+
+    /// The summary of every sample, in constant time.
+    peak_summary<T> summary() const {
+        return root_ ? root_->subtree : peak_summary<T>();
+    }
+
+    /// The exact summary of samples [first, last).
+    peak_summary<T> summarize(const size_t first, const size_t last) const {
+        assert_true(first < last and last <= size());
+        peak_summary<T> summary;
+        summarize(root_.get(), first, last, summary);
+        return summary;
+    }
+
+    /// The number of chunks, in O(chunks).
+    size_t chunks_size() const {
+        return chunks_size(root_.get());
+    }
+
+    /// The number of nodes on the longest path from the root, in O(chunks).
+    size_t height() const {
+        return height(root_.get());
+    }
+
+    /** Writes the summary of each of 'ranges_size' columns to 'output_iter', in order.
+
+        The columns are exactly the ranges for_n_ranges_linear() would divide the samples into. @see for_n_ranges_linear() for the parameters.
+    */
+    template<typename OutputIter>
+    OutputIter columns(OutputIter output_iter, const size_t ranges_size, const size_t distribution_offset) const {
+        const n_ranges_linear_desc desc(size(), ranges_size, distribution_offset);
+        n_ranges_linear_stepper step(desc);
+        while(step.range_index < ranges_size) {
+            const size_t b = step.range_begin;
+            *output_iter++ = summarize(b, b + step.next_size());
+        }
+        return output_iter;
+    }
+
+private:
+    static size_t size_of(node const* n) {
+        return n ? n->subtree.count : 0;
+    }
+
+    static void update(node& n) {
+        n.subtree = n.left ? n.left->subtree : peak_summary<T>();
+        n.subtree.merge(n.chunk);
+        if(n.right) {
+            n.subtree.merge(n.right->subtree);
+        }
+    }
+
+    node_ptr make_node(std::vector<T>&& samples, const uint32_t priority) {
+        node_ptr n(new node);
+        n->samples = std::move(samples);
+        n->chunk = peak_summary<T>::of(n->samples.data(), n->samples.data() + n->samples.size());
+        n->priority = priority;
+        update(*n);
+        return n;
+    }
+
+    uint32_t next_priority() {
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        return seed_;
+    }
+
+    static size_t chunks_size(node const* n) {
+        return n ? chunks_size(n->left.get()) + 1 + chunks_size(n->right.get()) : 0;
+    }
+
+    static size_t height(node const* n) {
+        return n ? 1 + std::max(height(n->left.get()), height(n->right.get())) : 0;
+    }
+
+    static void append_samples(node const* n, std::vector<T>& samples) {
+        if(n) {
+            append_samples(n->left.get(), samples);
+            samples.insert(samples.end(), n->samples.begin(), n->samples.end());
+            append_samples(n->right.get(), samples);
+        }
+    }
+
+    // Links the subtree 'nodes' in before sample 'index', and merges small chunks at both of its ends.
+    void insert_nodes(const size_t index, node_ptr nodes) {
+        assert_true(index <= size());
+        const size_t inserted = size_of(nodes.get());
+        auto halves = split(std::move(root_), index);
+        root_ = merge(merge(std::move(halves.first), std::move(nodes)), std::move(halves.second));
+        coalesce(index);
+        coalesce(index + inserted);
+    }
+
+    // Merges the chunks either side of the boundary before sample 'index' if either holds fewer than chunk_size/2 samples, into one chunk if they fit or else two equal ones.
+    void coalesce(const size_t index) {
+        if(index == 0 or index >= size()) {
+            return;
+        }
+        size_t left_begin = 0, right_begin = 0;
+        node const* left = locate(index - 1, left_begin);
+        node const* right = locate(index, right_begin);
+        if(left == right or (left->samples.size() >= chunk_size_ / 2 and right->samples.size() >= chunk_size_ / 2)) {
+            return;
+        }
+
+        // Splitting at chunk boundaries leaves exactly the two chunks in the middle.
+        const size_t pair_size = left->samples.size() + right->samples.size();
+        auto head = split(std::move(root_), left_begin);
+        auto tail = split(std::move(head.second), pair_size);
+        std::vector<T> samples;
+        samples.reserve(pair_size);
+        append_samples(tail.first.get(), samples);
+
+        node_ptr middle;
+        if(pair_size <= chunk_size_) {
+            middle = make_node(std::move(samples), next_priority());
+        }
+        else {
+            std::vector<T> second(samples.begin() + pair_size / 2, samples.end());
+            samples.resize(pair_size / 2);
+            middle = merge(make_node(std::move(samples), next_priority()), make_node(std::move(second), next_priority()));
+        }
+        root_ = merge(merge(std::move(head.first), std::move(middle)), std::move(tail.second));
+    }
+
+    template<typename ForwardIter>
+    node_ptr build(ForwardIter begin, ForwardIter end) {
+        node_ptr root;
+        while(begin != end) {
+            std::vector<T> samples;
+            samples.reserve(chunk_size_);
+            for(; begin != end and samples.size() < chunk_size_; ++begin) {
+                samples.push_back(*begin);
+            }
+            root = merge(std::move(root), make_node(std::move(samples), next_priority()));
+        }
+        return root;
+    }
+
+    // The chunk holding sample 'index', setting 'chunk_begin' to the index of its first sample, or nullptr if index >= size().
+    node const* locate(size_t index, size_t& chunk_begin) const {
+        chunk_begin = index;
+        node const* n = root_.get();
+        while(n) {
+            const size_t left_size = size_of(n->left.get());
+            if(index < left_size) {
+                n = n->left.get();
+            }
+            else if(index - left_size < n->samples.size()) {
+                chunk_begin -= index - left_size;
+                return n;
+            }
+            else {
+                index -= left_size + n->samples.size();
+                n = n->right.get();
+            }
+        }
+        return nullptr;
+    }
+
+    // Splits 't' into its first 'index' samples and the rest, dividing the chunk that straddles 'index' in two.
+    std::pair<node_ptr, node_ptr> split(node_ptr t, const size_t index) {
+        if(not t) {
+            return std::pair<node_ptr, node_ptr>();
+        }
+        const size_t left_size = size_of(t->left.get());
+        const size_t chunk_end = left_size + t->samples.size();
+        if(index <= left_size) {
+            auto halves = split(std::move(t->left), index);
+            t->left = std::move(halves.second);
+            update(*t);
+            return std::make_pair(std::move(halves.first), std::move(t));
+        }
+        if(index >= chunk_end) {
+            auto halves = split(std::move(t->right), index - chunk_end);
+            t->right = std::move(halves.first);
+            update(*t);
+            return std::make_pair(std::move(t), std::move(halves.second));
+        }
+
+        // The tail of the chunk becomes a new node, merged in front of the right subtree.
+        std::vector<T> tail(t->samples.begin() + (index - left_size), t->samples.end());
+        t->samples.resize(index - left_size);
+        t->chunk = peak_summary<T>::of(t->samples.data(), t->samples.data() + t->samples.size());
+        node_ptr right = merge(make_node(std::move(tail), next_priority()), std::move(t->right));
+        update(*t);
+        return std::make_pair(std::move(t), std::move(right));
+    }
+
+    // Joins 'a' and 'b', all of the samples of 'a' coming first. Equal priorities are ordered at random.
+    node_ptr merge(node_ptr a, node_ptr b) {
+        if(not a or not b) {
+            return a ? std::move(a) : std::move(b);
+        }
+        if(a->priority > b->priority or (a->priority == b->priority and (next_priority() & 1))) {
+            a->right = merge(std::move(a->right), std::move(b));
+            update(*a);
+            return a;
+        }
+        b->left = merge(std::move(a), std::move(b->left));
+        update(*b);
+        return b;
+    }
+
+    // Merges the summary of samples [first, last) of the subtree 't' into 'summary'.
+    static void summarize(node const* t, const size_t first, const size_t last, peak_summary<T>& summary) {
+        if(t == nullptr or first >= last) {
+            return;
+        }
+        if(first == 0 and last >= t->subtree.count) {
+            summary.merge(t->subtree);
+            return;
+        }
+        const size_t left_size = size_of(t->left.get());
+        const size_t chunk_end = left_size + t->samples.size();
+        if(first < left_size) {
+            summarize(t->left.get(), first, std::min(last, left_size), summary);
+        }
+        const size_t b = std::max(first, left_size);
+        const size_t e = std::min(last, chunk_end);
+        if(b == left_size and e == chunk_end) {
+            summary.merge(t->chunk);
+        }
+        else if(b < e) {
+            summary.merge(peak_summary<T>::of(t->samples.data() + (b - left_size), t->samples.data() + (e - left_size)));
+        }
+        if(last > chunk_end) {
+            summarize(t->right.get(), std::max(first, chunk_end) - chunk_end, last - chunk_end, summary);
+        }
+    }
+
+    node_ptr    root_;
+    size_t      chunk_size_;
+    uint32_t    seed_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[summary_rope] VALID summary_rope(...)") {
+
+    unsigned seed = 11;
+    auto random = [&seed]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+    vector<short> mirror(30011);
+    for(auto& s : mirror) {
+        s = short(random());
+    }
+    summary_rope<short> rope(mirror.begin(), mirror.end(), 256);
+
+    auto check = [&](peak_summary<short> const& summary, size_t first, size_t last) {
+        const auto minmax = minmax_element(mirror.begin() + first, mirror.begin() + last);
+        REQUIRE(summary.count == last - first);
+        REQUIRE(summary.min == *minmax.first);
+        REQUIRE(summary.max == *minmax.second);
+        REQUIRE(summary.sum == accumulate(mirror.begin() + first, mirror.begin() + last, int64_t(0)));
+    };
+
+    SUBCASE("[summary_rope] random access iterators") {
+        REQUIRE(rope.size() == mirror.size());
+        CHECK(equal(rope.begin(), rope.end(), mirror.begin(), mirror.end()));
+        CHECK(rope.end() - rope.begin() == ptrdiff_t(mirror.size()));
+        auto i = rope.begin() + 1000;
+        CHECK(*i == mirror[1000]);
+        CHECK(*(i - 999) == mirror[1]);
+        CHECK(i[5000] == mirror[6000]);
+        CHECK(rope[30010] == mirror[30010]);
+        CHECK(*--rope.end() == mirror.back());
+    }
+
+    SUBCASE("[summary_rope] edits match a vector") {
+        for(int edit = 0; edit < 200; ++edit) {
+            const size_t first = random() % (mirror.size() + 1);
+            const size_t last = first + random() % min<size_t>(3000, mirror.size() - first + 1);
+            switch(edit % 3) {
+            case 0: {
+                vector<short> inserted(random() % 2000);
+                for(auto& s : inserted) {
+                    s = short(random());
+                }
+                rope.insert(first, inserted.begin(), inserted.end());
+                mirror.insert(mirror.begin() + first, inserted.begin(), inserted.end());
+                break;
+            }
+            case 1:
+                rope.erase(first, last);
+                mirror.erase(mirror.begin() + first, mirror.begin() + last);
+                break;
+            default: {
+                // Cut [first, last) and paste it back at another position.
+                auto clip = rope.extract(first, last);
+                REQUIRE(equal(clip.begin(), clip.end(), mirror.begin() + first, mirror.begin() + last));
+                vector<short> moved(mirror.begin() + first, mirror.begin() + last);
+                mirror.erase(mirror.begin() + first, mirror.begin() + last);
+                const size_t at = random() % (mirror.size() + 1);
+                rope.insert(at, move(clip));
+                mirror.insert(mirror.begin() + at, moved.begin(), moved.end());
+            }
+            }
+            REQUIRE(rope.size() == mirror.size());
+            if(not mirror.empty()) {
+                check(rope.summary(), 0, mirror.size());
+                const size_t b = random() % mirror.size();
+                const size_t e = b + 1 + random() % (mirror.size() - b);
+                check(rope.summarize(b, e), b, e);
+            }
+        }
+        CHECK(equal(rope.begin(), rope.end(), mirror.begin(), mirror.end()));
+    }
+
+    SUBCASE("[summary_rope] many small edits keep the tree shallow and the chunks large") {
+        summary_rope<short> small(16);
+        vector<short> expected;
+        for(size_t n = 0; n < 20000; ++n) {
+            const short s = short(random());
+            const size_t at = random() % (expected.size() + 1);
+            small.insert(at, &s, &s + 1);
+            expected.insert(expected.begin() + at, s);
+        }
+        for(int edit = 0; edit < 2000; ++edit) {
+            const size_t first = random() % expected.size();
+            const size_t last = first + random() % min<size_t>(40, expected.size() - first);
+            auto clip = small.extract(first, last);
+            vector<short> moved(expected.begin() + first, expected.begin() + last);
+            expected.erase(expected.begin() + first, expected.begin() + last);
+            const size_t at = random() % (expected.size() + 1);
+            small.insert(at, move(clip));
+            expected.insert(expected.begin() + at, moved.begin(), moved.end());
+        }
+        REQUIRE(equal(small.begin(), small.end(), expected.begin(), expected.end()));
+
+        // A random treap is about 3 * log2(chunks) deep, a chain would be thousands.
+        size_t log2_chunks = 0;
+        while((size_t(1) << log2_chunks) < small.chunks_size()) {
+            ++log2_chunks;
+        }
+        CHECK(small.height() <= 4 * log2_chunks);
+        CHECK(small.chunks_size() <= expected.size() / 4);
+    }
+
+    SUBCASE("[summary_rope] for_n_ranges_linear(), range_stats() and columns() over the rope") {
+        rope.erase(100, 200);
+        mirror.erase(mirror.begin() + 100, mirror.begin() + 200);
+        const vector<short> pasted(mirror.begin(), mirror.begin() + 777);
+        rope.insert(5000, pasted.begin(), pasted.end());
+        mirror.insert(mirror.begin() + 5000, pasted.begin(), pasted.end());
+
+        vector<peak_summary<short>> columns;
+        rope.columns(back_inserter(columns), 640, 1);
+        size_t i = 0;
+        for_n_ranges_linear(rope.begin(), rope.end(), 640, 1, [&](size_t, auto b, auto e) {
+            const size_t first = b - rope.begin();
+            const size_t last = e - rope.begin();
+            REQUIRE(equal(b, e, mirror.begin() + first, mirror.begin() + last));
+            check(columns[i++], first, last);
+            const auto stats = range_stats(b, e);
+            const auto expected = range_stats(mirror.begin() + first, mirror.begin() + last);
+            REQUIRE(stats.min == expected.min);
+            REQUIRE(stats.max == expected.max);
+            REQUIRE(stats.min_index == expected.min_index);
+            REQUIRE(stats.max_index == expected.max_index);
+            REQUIRE(stats.sum == expected.sum);
+        });
+        CHECK(i == 640);
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // summary_rope_h
@@ -0,0 +1,351 @@
+/*
+    Copyright (c) 2017 Jeremy Jurksztowicz
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the "Software"), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in all
+    copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+    SOFTWARE.
+*/
+
+#ifndef work_stealing_pool_h
+#define work_stealing_pool_h
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <condition_variable>
+
+#ifndef DOCTEST_CONFIG_DISABLE
+#include <doctest.h>
+
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#endif
+
+namespace ec {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** A persistent pool of threads that cooperatively run indexed loops.
+
+    Threads are created once and sleep between jobs, so running a loop costs a wake up rather than a thread creation per task. Each call to for_each_index() splits its index space evenly between the participants (the pool threads plus the calling thread). Every participant owns a deque of [begin, end) index blocks, takes small grains off the front of its own deque, and when it runs dry steals the back half of the last block in another participant's deque. A participant's deque holds its initial block plus any blocks it has stolen, so this is usually half of the victim's remaining indexes, and never more. Uneven per-index costs are therefore balanced without a shared counter being hit for every grain.
+
+    Results are best written into indexed slots rather than futures:
+
+        vector<peak> peaks(width);
+        pool.for_each_index(width, [&](size_t i) { peaks[i] = analyze(i); });
+
+    One loop runs at a time; concurrent callers queue behind each other. Loops started from inside a pool task run serially on the calling thread instead of deadlocking.
+*/
+class work_stealing_pool {
+public:
+    /// Creates 'threads_size' background threads, the thread calling for_each_index() also takes part.
+    explicit work_stealing_pool(const size_t threads_size = default_threads_size())
+    : queues_(new queue[threads_size + 1])
+    , participants_size_(threads_size + 1) {
+        threads_.reserve(threads_size);
+        for(size_t t = 0; t < threads_size; ++t) {
+            threads_.emplace_back([this, t]() { thread_main(t + 1); });
+        }
+    }
+
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for(auto& t : threads_) {
+            t.join();
+        }
+    }
+
+    work_stealing_pool(work_stealing_pool const&) = delete;
+    work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+    /// The number of threads taking part in a loop, including the calling thread.
+    size_t size() const {
+        return participants_size_;
+    }
+
+    /** Calls 'index_func(i)' for every i in [0, indexes_size) and blocks until all calls have returned.
+
+        The order of the calls is unspecified and 'index_func' must be safe to call concurrently. If 'index_func' throws, the indexes that have not yet started are abandoned and the first exception is rethrown on the calling thread.
+    */
+    template<typename IndexFunc>
+    void for_each_index(const size_t indexes_size, IndexFunc index_func) {
+        auto block_func = [&index_func](size_t b, size_t e) {
+            for(; b < e; ++b) {
+                index_func(b);
+            }
+        };
+
+        if(inside_task() or participants_size_ == 1 or indexes_size < 2) {
+            block_func(0, indexes_size);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+
+        job_context_ = &block_func;
+        job_call_ = [](void* context, size_t b, size_t e) {
+            (*static_cast<decltype(block_func)*>(context))(b, e);
+        };
+        grain_size_ = std::max<size_t>(1, indexes_size / (participants_size_ * 16));
+        failed_ = false;
+        first_exception_ = nullptr;
+        for(size_t p = 0; p < participants_size_; ++p) {
+            queues_[p].blocks.clear();
+            const size_t b = indexes_size * p / participants_size_;
+            const size_t e = indexes_size * (p + 1) / participants_size_;
+            if(b < e) {
+                queues_[p].blocks.emplace_back(b, e);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state_mutex_);
+            busy_ = participants_size_ - 1;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        run_participant(0);
+
+        {
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            done_.wait(lock, [this]() { return busy_ == 0; });
+        }
+
+        if(first_exception_) {
+            std::rethrow_exception(first_exception_);
+        }
+    }
+
+    /// The process wide pool used by the execution policy overloads, created on first use.
+    static work_stealing_pool& shared() {
+        static work_stealing_pool pool;
+        return pool;
+    }
+
+    static size_t default_threads_size() {
+        const size_t hardware_threads = std::thread::hardware_concurrency();
+        return hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+
+private:
+    struct queue {
+        std::mutex                              mutex;
+        std::deque<std::pair<size_t, size_t>>   blocks;
+    };
+
+    static bool& inside_task() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    void thread_main(const size_t participant) {
+        size_t seen_generation = 0;
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(state_mutex_);
+                wake_.wait(lock, [&]() { return stopping_ or generation_ != seen_generation; });
+                if(stopping_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+
+            run_participant(participant);
+
+            bool last = false;
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                last = --busy_ == 0;
+            }
+            if(last) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    void run_participant(const size_t participant) {
+        inside_task() = true;
+        std::pair<size_t, size_t> grain;
+        while(not failed_ and (pop(participant, grain) or steal(participant, grain))) {
+            try {
+                job_call_(job_context_, grain.first, grain.second);
+            }
+            catch(...) {
+                if(not failed_.exchange(true)) {
+                    first_exception_ = std::current_exception();
+                }
+            }
+        }
+        inside_task() = false;
+    }
+
+    // Takes a grain off the front of our own blocks.
+    bool pop(const size_t participant, std::pair<size_t, size_t>& grain) {
+        queue& q = queues_[participant];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if(q.blocks.empty()) {
+            return false;
+        }
+        auto& front = q.blocks.front();
+        grain.first = front.first;
+        grain.second = std::min(front.second, front.first + grain_size_);
+        front.first = grain.second;
+        if(front.first == front.second) {
+            q.blocks.pop_front();
+        }
+        return true;
+    }
+
+    // Moves the back half of the last block of the first participant with any blocks left into our own blocks, then pops.
+    bool steal(const size_t participant, std::pair<size_t, size_t>& grain) {
+        for(size_t v = 1; v < participants_size_; ++v) {
+            queue& victim = queues_[(participant + v) % participants_size_];
+            std::pair<size_t, size_t> stolen;
+            {
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if(victim.blocks.empty()) {
+                    continue;
+                }
+                auto& back = victim.blocks.back();
+                const size_t half = (back.second - back.first + 1) / 2;
+                stolen = std::make_pair(back.second - half, back.second);
+                back.second -= half;
+                if(back.first == back.second) {
+                    victim.blocks.pop_back();
+                }
+            }
+            {
+                queue& own = queues_[participant];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.blocks.push_back(stolen);
+            }
+            return pop(participant, grain);
+        }
+        return false;
+    }
+
+    std::vector<std::thread>        threads_;
+    std::unique_ptr<queue[]>        queues_;
+    const size_t                    participants_size_;
+
+    std::mutex                      submit_mutex_;
+    std::mutex                      state_mutex_;
+    std::condition_variable         wake_;
+    std::condition_variable         done_;
+    size_t                          generation_ = 0;
+    size_t                          busy_ = 0;
+    bool                            stopping_ = false;
+
+    void*                           job_context_ = nullptr;
+    void                            (*job_call_)(void*, size_t, size_t) = nullptr;
+    size_t                          grain_size_ = 1;
+    std::atomic<bool>               failed_ { false };
+    std::exception_ptr              first_exception_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace test {
+
+using namespace std;
+
+TEST_CASE("[work_stealing_pool] VALID for_each_index(...)") {
+
+    work_stealing_pool pool(3);
+    REQUIRE(pool.size() == 4);
+
+    SUBCASE("[work_stealing_pool] every index visited exactly once, repeatedly") {
+        for(size_t indexes_size : {0, 1, 2, 7, 1000, 100003}) {
+            vector<atomic<int>> visits(indexes_size);
+            pool.for_each_index(indexes_size, [&](size_t i) { ++visits[i]; });
+            CHECK(all_of(visits.begin(), visits.end(), [](auto const& v) { return v == 1; }));
+        }
+    }
+
+    SUBCASE("[work_stealing_pool] uneven costs are stolen") {
+        // The calling thread owns indexes [0, 1000), and each of them holds it until another participant has run one.
+        const auto caller = this_thread::get_id();
+        vector<thread::id> runners(4000);
+        atomic<bool> stolen(false);
+        const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+        pool.for_each_index(runners.size(), [&](size_t i) {
+            runners[i] = this_thread::get_id();
+            if(i < 1000) {
+                if(runners[i] != caller) {
+                    stolen = true;
+                }
+                while(not stolen and chrono::steady_clock::now() < deadline) {
+                    this_thread::yield();
+                }
+            }
+        });
+        CHECK(stolen);
+        CHECK(count_if(runners.begin(), runners.begin() + 1000, [&](thread::id id) { return id != caller; }) > 0);
+    }
+
+    SUBCASE("[work_stealing_pool] nested loops run inline") {
+        vector<atomic<int>> visits(64 * 64);
+        pool.for_each_index(64, [&](size_t i) {
+            pool.for_each_index(64, [&](size_t j) { ++visits[i * 64 + j]; });
+        });
+        CHECK(all_of(visits.begin(), visits.end(), [](auto const& v) { return v == 1; }));
+    }
+
+    SUBCASE("[work_stealing_pool] exceptions propagate and the pool stays usable") {
+        REQUIRE_THROWS(pool.for_each_index(1000, [](size_t i) {
+            if(i == 500) { throw runtime_error("index 500"); }
+        }));
+        atomic<size_t> count(0);
+        pool.for_each_index(1000, [&](size_t) { ++count; });
+        CHECK(count == 1000);
+    }
+}
+
+} // END namespace test
+} // END namespace ec
+
+#endif // work_stealing_pool_h